@@ -0,0 +1,585 @@
+// Read and write throughput benchmarks on synthesized STL files.
+//
+// Usage: tiny_stl_bench [--sizes 1000,100000,1000000] [--repetitions 3] [--threads 0]
+//                       [--dir .] [--json results.json] [--max-memory 1024] [--keep]
+//
+// For every size a binary file and ASCII files with different float formatting are generated,
+// then each benchmark is run --repetitions times and the fastest run is reported
+// as MB/s and triangles/s, optionally also written as JSON for tracking across versions.
+// Files are generated block by block, so large sizes (100M triangles) only need disk space,
+// benchmarks that read a whole file into memory are skipped for files over --max-memory MB.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tiny_stl.hpp>
+#include <tiny_stl_static.hpp>
+
+namespace
+{
+    struct Options
+    {
+        std::vector<size_t> sizes{1000, 100000, 1000000};
+        int repetitions = 3;
+        unsigned num_threads = 0;
+        std::string dir = ".";
+        std::string json_path;
+        bool keep_files = false;
+        // Benchmarks that hold a whole file in memory are skipped for larger files
+        uint64_t max_memory = 1024ull * 1024 * 1024;
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t num_triangles = 0;
+        uint64_t num_bytes = 0;
+        double seconds = 0.0;
+    };
+
+    // Float formats used for the generated ASCII files
+    struct ASCII_Variant
+    {
+        const char *name;
+        const char *format;
+    };
+
+    const ASCII_Variant ASCII_VARIANTS[] = {
+        {"ascii_short", "%g"},
+        {"ascii_exponent", "%.8e"},
+        {"ascii_fixed", "%f"},
+    };
+
+    constexpr size_t BATCH_SIZE = 4096;
+    // Binary batches are only decoded in parallel when they hold at least this many triangles per thread
+    constexpr size_t PARALLEL_BATCH_SIZE_PER_THREAD = 64 * 1024;
+
+    // Prevents the optimizer from discarding decoded triangles
+    volatile float g_sink = 0.0f;
+
+    // Triangles are generated and written in blocks of this many, so no size is ever held in memory whole
+    constexpr size_t GENERATE_BLOCK_SIZE = 64 * 1024;
+
+    // Triangle index of the benchmark files, a seeded function of index only,
+    // so that files can be generated block by block and every run sees the same data
+    void make_triangle(uint64_t index, Tiny_STL::Triangle *t)
+    {
+        // splitmix64
+        uint64_t state = 42 + index * 12 * 0x9e3779b97f4a7c15ull;
+        auto coordinate = [&]()
+        {
+            state += 0x9e3779b97f4a7c15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            z ^= z >> 31;
+            // 24 random bits mapped to [-1000, 1000)
+            return (float)(z >> 40) * (2000.0f / 16777216.0f) - 1000.0f;
+        };
+        for (int i = 0; i < 3; i++)
+        {
+            t->normal[i] = coordinate() / 1000.0f;
+            for (int v = 0; v < 3; v++)
+            {
+                t->vertices[v][i] = coordinate();
+            }
+        }
+    }
+
+    // Fills triangles with the count triangles starting at index first
+    void make_triangles(uint64_t first, size_t count, std::vector<Tiny_STL::Triangle> *triangles)
+    {
+        triangles->resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            make_triangle(first + i, &(*triangles)[i]);
+        }
+    }
+
+    uint64_t file_size(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fclose(file);
+        return (uint64_t)size;
+    }
+
+    // Files are generated without tiny_stl, so readers are measured against independent output
+    void generate_binary(const std::string &path, size_t num_triangles)
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+        char header[80] = "tiny_stl_bench";
+        uint32_t num_tris = (uint32_t)num_triangles;
+        fwrite(header, sizeof(header), 1, file);
+        fwrite(&num_tris, sizeof(num_tris), 1, file);
+
+        constexpr size_t RECORD_SIZE = 50;
+        std::vector<Tiny_STL::Triangle> triangles;
+        std::vector<char> records(GENERATE_BLOCK_SIZE * RECORD_SIZE, 0);
+        for (size_t first = 0; first < num_triangles; first += GENERATE_BLOCK_SIZE)
+        {
+            size_t count = std::min(GENERATE_BLOCK_SIZE, num_triangles - first);
+            make_triangles(first, count, &triangles);
+            for (size_t i = 0; i < count; i++)
+            {
+                // Attribute byte count stays 0
+                char *record = records.data() + i * RECORD_SIZE;
+                memcpy(record, triangles[i].normal, sizeof(triangles[i].normal));
+                memcpy(record + sizeof(triangles[i].normal), triangles[i].vertices, sizeof(triangles[i].vertices));
+            }
+            fwrite(records.data(), RECORD_SIZE, count, file);
+        }
+        fclose(file);
+    }
+
+    void generate_ascii(const std::string &path, size_t num_triangles, const char *float_format)
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        // Whole facets are formatted with a single call into a buffer that is written in large blocks
+        const std::string vector_format = std::string(float_format) + " " + float_format + " " + float_format + "\n";
+        const std::string facet_format = "  facet normal " + vector_format + "    outer loop\n" +
+                                         "      vertex " + vector_format + "      vertex " + vector_format + "      vertex " + vector_format +
+                                         "    endloop\n  endfacet\n";
+        constexpr size_t FLUSH_SIZE = 1024 * 1024;
+        constexpr size_t MAX_FACET_SIZE = 1024;
+        std::vector<char> buffer(FLUSH_SIZE + MAX_FACET_SIZE);
+        size_t buffer_size = 0;
+
+        fprintf(file, "solid tiny_stl_bench\n");
+        std::vector<Tiny_STL::Triangle> triangles;
+        for (size_t first = 0; first < num_triangles; first += GENERATE_BLOCK_SIZE)
+        {
+            size_t count = std::min(GENERATE_BLOCK_SIZE, num_triangles - first);
+            make_triangles(first, count, &triangles);
+            for (const auto &t : triangles)
+            {
+                int size = snprintf(buffer.data() + buffer_size, MAX_FACET_SIZE, facet_format.c_str(),
+                                    t.normal[0], t.normal[1], t.normal[2],
+                                    t.vertices[0][0], t.vertices[0][1], t.vertices[0][2],
+                                    t.vertices[1][0], t.vertices[1][1], t.vertices[1][2],
+                                    t.vertices[2][0], t.vertices[2][1], t.vertices[2][2]);
+                if (size < 0 || (size_t)size >= MAX_FACET_SIZE)
+                {
+                    throw std::runtime_error("Failed to format facet");
+                }
+                buffer_size += (size_t)size;
+                if (buffer_size >= FLUSH_SIZE)
+                {
+                    fwrite(buffer.data(), 1, buffer_size, file);
+                    buffer_size = 0;
+                }
+            }
+        }
+        fwrite(buffer.data(), 1, buffer_size, file);
+        fprintf(file, "endsolid tiny_stl_bench\n");
+        fclose(file);
+    }
+
+    double time_once(const std::function<void()> &fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    class Runner
+    {
+    private:
+        const Options &m_options;
+        std::vector<Result> m_results;
+
+    public:
+        explicit Runner(const Options &options) : m_options(options) {}
+
+        // fn runs the benchmark once and returns the number of bytes it read or wrote
+        void run(const std::string &name, size_t num_triangles, const std::function<uint64_t()> &fn)
+        {
+            Result result;
+            result.name = name;
+            result.num_triangles = num_triangles;
+            for (int i = 0; i < m_options.repetitions; i++)
+            {
+                uint64_t num_bytes = 0;
+                double seconds = time_once([&]()
+                {
+                    num_bytes = fn();
+                });
+                if (i == 0 || seconds < result.seconds)
+                {
+                    result.seconds = seconds;
+                }
+                result.num_bytes = num_bytes;
+            }
+
+            printf("%-48s %12zu tris %10.1f MB/s %14.0f tris/s\n", result.name.c_str(), result.num_triangles,
+                   result.num_bytes / result.seconds / 1e6, result.num_triangles / result.seconds);
+            fflush(stdout);
+            m_results.push_back(result);
+        }
+
+        void write_json(const std::string &path) const
+        {
+            FILE *file = fopen(path.c_str(), "wb");
+            if (!file)
+            {
+                throw std::runtime_error("Failed to open " + path);
+            }
+
+            fprintf(file, "{\n  \"context\": {\n");
+            fprintf(file, "    \"repetitions\": %d,\n", m_options.repetitions);
+            fprintf(file, "    \"num_threads\": %u\n", m_options.num_threads);
+            fprintf(file, "  },\n  \"benchmarks\": [\n");
+            for (size_t i = 0; i < m_results.size(); i++)
+            {
+                const Result &r = m_results[i];
+                fprintf(file, "    {\"name\": \"%s\", \"triangles\": %zu, \"bytes\": %" PRIu64 ", \"real_time_s\": %.9f, "
+                              "\"bytes_per_second\": %.1f, \"triangles_per_second\": %.1f}%s\n",
+                        r.name.c_str(), r.num_triangles, r.num_bytes, r.seconds,
+                        r.num_bytes / r.seconds, r.num_triangles / r.seconds,
+                        (i + 1 < m_results.size()) ? "," : "");
+            }
+            fprintf(file, "  ]\n}\n");
+            fclose(file);
+        }
+    };
+
+    size_t read_all_batched(const std::string &path, const Tiny_STL::Reader_Options &options, size_t batch_size = BATCH_SIZE)
+    {
+        auto reader = Tiny_STL::create_reader(path.c_str(), options);
+        std::vector<Tiny_STL::Triangle> batch(batch_size);
+        size_t total = 0;
+        size_t count;
+        while ((count = reader->read_triangles(batch.data(), batch.size())) > 0)
+        {
+            g_sink = g_sink + batch[0].vertices[0][0];
+            total += count;
+        }
+        return total;
+    }
+
+    size_t read_all_one_by_one(const std::string &path, const Tiny_STL::Reader_Options &options)
+    {
+        auto reader = Tiny_STL::create_reader(path.c_str(), options);
+        Tiny_STL::Triangle t;
+        size_t total = 0;
+        while (reader->read_next_triangle(&t))
+        {
+            g_sink = g_sink + t.vertices[0][0];
+            total++;
+        }
+        return total;
+    }
+
+    size_t read_all_views(const std::string &path)
+    {
+        auto reader = Tiny_STL::create_reader(path.c_str());
+        return Tiny_STL::for_each_triangle(reader.get(), [](const Tiny_STL::Triangle_View &t)
+        {
+            g_sink = g_sink + t.vertex(0, 0);
+        });
+    }
+
+    // Same loop through the virtual reader and through the static reader,
+    // both decoding from memory so that only the call overhead differs
+    size_t read_memory_one_by_one(const std::vector<char> &data)
+    {
+        auto reader = Tiny_STL::create_reader(data.data(), data.size());
+        Tiny_STL::Triangle t;
+        size_t total = 0;
+        while (reader->read_next_triangle(&t))
+        {
+            g_sink = g_sink + t.vertices[0][0];
+            total++;
+        }
+        return total;
+    }
+
+    size_t read_memory_static_binary(const std::vector<char> &data)
+    {
+        Tiny_STL::Static_Binary_Reader reader(data.data(), data.size());
+        return reader.for_each_triangle([](const Tiny_STL::Triangle &t)
+        {
+            g_sink = g_sink + t.vertices[0][0];
+        });
+    }
+
+    void check_count(size_t actual, size_t expected, const std::string &name)
+    {
+        if (actual != expected)
+        {
+            throw std::runtime_error(name + ": read " + std::to_string(actual) + " triangles, expected " + std::to_string(expected));
+        }
+    }
+
+    void bench_size(Runner &runner, const Options &options, size_t num_triangles)
+    {
+        const std::string suffix = "/" + std::to_string(num_triangles);
+        const std::string prefix = options.dir + "/tiny_stl_bench_" + std::to_string(num_triangles);
+        std::vector<std::string> generated;
+
+        auto fits_in_memory = [&](const std::string &name, uint64_t size)
+        {
+            if (size > options.max_memory)
+            {
+                printf("%-48s skipped, file does not fit in --max-memory\n", (name + suffix).c_str());
+                return false;
+            }
+            return true;
+        };
+
+        // Readers
+        const std::string binary_path = prefix + "_binary.stl";
+        generate_binary(binary_path, num_triangles);
+        generated.push_back(binary_path);
+        const uint64_t binary_size = file_size(binary_path);
+
+        auto bench_read = [&](const std::string &name, const std::string &path, uint64_t size, Tiny_STL::Reader_Options reader_options, bool one_by_one)
+        {
+            runner.run(name + suffix, num_triangles, [&]()
+            {
+                size_t count = one_by_one ? read_all_one_by_one(path, reader_options) : read_all_batched(path, reader_options);
+                check_count(count, num_triangles, name);
+                return size;
+            });
+        };
+
+        Tiny_STL::Reader_Options reader_options;
+        bench_read("read/binary/mmap/read_triangles", binary_path, binary_size, reader_options, false);
+        bench_read("read/binary/mmap/read_next_triangle", binary_path, binary_size, reader_options, true);
+        runner.run("read/binary/mmap/for_each_triangle" + suffix, num_triangles, [&]()
+        {
+            check_count(read_all_views(binary_path), num_triangles, "read/binary/mmap/for_each_triangle");
+            return binary_size;
+        });
+        reader_options.use_mmap = false;
+        bench_read("read/binary/stdio/read_triangles", binary_path, binary_size, reader_options, false);
+        bench_read("read/binary/stdio/read_next_triangle", binary_path, binary_size, reader_options, true);
+        reader_options.use_mmap = true;
+        reader_options.num_threads = options.num_threads;
+        // Smallest batch that is split across all threads, larger ones only leave the cache
+        unsigned num_threads = options.num_threads ? options.num_threads : std::max(std::thread::hardware_concurrency(), 1u);
+        const size_t parallel_batch_size = PARALLEL_BATCH_SIZE_PER_THREAD * num_threads;
+        runner.run("read/binary/mmap_parallel/read_triangles" + suffix, num_triangles, [&]()
+        {
+            check_count(read_all_batched(binary_path, reader_options, parallel_batch_size), num_triangles, "read/binary/mmap_parallel/read_triangles");
+            return binary_size;
+        });
+
+        if (fits_in_memory("read/binary/memory", binary_size))
+        {
+            std::vector<char> binary_data(binary_size);
+            FILE *binary_file = fopen(binary_path.c_str(), "rb");
+            bool loaded = binary_file && fread(binary_data.data(), 1, binary_data.size(), binary_file) == binary_data.size();
+            if (binary_file)
+            {
+                fclose(binary_file);
+            }
+            if (!loaded)
+            {
+                throw std::runtime_error("Failed to read " + binary_path);
+            }
+            runner.run("read/binary/memory/read_next_triangle" + suffix, num_triangles, [&]()
+            {
+                check_count(read_memory_one_by_one(binary_data), num_triangles, "read/binary/memory/read_next_triangle");
+                return binary_size;
+            });
+            runner.run("read/binary/memory_static/for_each_triangle" + suffix, num_triangles, [&]()
+            {
+                check_count(read_memory_static_binary(binary_data), num_triangles, "read/binary/memory_static/for_each_triangle");
+                return binary_size;
+            });
+        }
+
+        for (const auto &variant : ASCII_VARIANTS)
+        {
+            const std::string ascii_path = prefix + "_" + variant.name + ".stl";
+            generate_ascii(ascii_path, num_triangles, variant.format);
+            generated.push_back(ascii_path);
+            const uint64_t ascii_size = file_size(ascii_path);
+            const std::string name = std::string("read/") + variant.name;
+
+            // Without a stream window ASCII files are read into memory whole
+            if (fits_in_memory(name, ascii_size))
+            {
+                reader_options = Tiny_STL::Reader_Options();
+                bench_read(name + "/read_triangles", ascii_path, ascii_size, reader_options, false);
+                bench_read(name + "/read_next_triangle", ascii_path, ascii_size, reader_options, true);
+                reader_options.num_threads = options.num_threads;
+                bench_read(name + "/parallel/read_triangles", ascii_path, ascii_size, reader_options, false);
+            }
+            reader_options = Tiny_STL::Reader_Options();
+            reader_options.stream_window_size = 1024 * 1024;
+            bench_read(name + "/stream/read_triangles", ascii_path, ascii_size, reader_options, false);
+            const std::string count_name = std::string("count/") + variant.name;
+            runner.run(count_name + suffix, num_triangles, [&]()
+            {
+                check_count(Tiny_STL::count_triangles(ascii_path.c_str()), num_triangles, count_name);
+                return ascii_size;
+            });
+        }
+
+        // Writers repeat one block of triangles, so that generating them is not measured
+        std::vector<Tiny_STL::Triangle> block;
+        make_triangles(0, std::min(GENERATE_BLOCK_SIZE, num_triangles), &block);
+        const std::string output_path = prefix + "_output.stl";
+        auto bench_write = [&](const std::string &name, Tiny_STL::File_Writer::Type type, bool one_by_one, unsigned num_threads, bool known_count = false)
+        {
+            runner.run(name + suffix, num_triangles, [&]()
+            {
+                {
+                    Tiny_STL::Writer_Options writer_options;
+                    writer_options.num_threads = num_threads;
+                    writer_options.triangle_count = known_count ? num_triangles : 0;
+                    auto writer = Tiny_STL::create_writer(output_path.c_str(), type, writer_options);
+                    for (size_t written = 0; written < num_triangles; written += block.size())
+                    {
+                        size_t count = std::min(block.size(), num_triangles - written);
+                        if (one_by_one)
+                        {
+                            for (size_t i = 0; i < count; i++)
+                            {
+                                writer->write_triangle(&block[i]);
+                            }
+                        }
+                        else
+                        {
+                            writer->write_triangles(block.data(), count);
+                        }
+                    }
+                }
+                return file_size(output_path);
+            });
+        };
+
+        bench_write("write/binary/write_triangles", Tiny_STL::File_Writer::Type::BINARY, false, 1);
+        bench_write("write/binary/write_triangle", Tiny_STL::File_Writer::Type::BINARY, true, 1);
+        bench_write("write/binary/known_count/write_triangles", Tiny_STL::File_Writer::Type::BINARY, false, 1, true);
+        bench_write("write/binary/known_count/write_triangle", Tiny_STL::File_Writer::Type::BINARY, true, 1, true);
+        bench_write("write/ascii/write_triangles", Tiny_STL::File_Writer::Type::ASCII, false, 1);
+        bench_write("write/ascii/write_triangle", Tiny_STL::File_Writer::Type::ASCII, true, 1);
+        bench_write("write/ascii/parallel/write_triangles", Tiny_STL::File_Writer::Type::ASCII, false, options.num_threads);
+        generated.push_back(output_path);
+
+        if (!options.keep_files)
+        {
+            for (const auto &path : generated)
+            {
+                remove(path.c_str());
+            }
+        }
+    }
+
+    std::vector<size_t> parse_sizes(const char *arg)
+    {
+        std::vector<size_t> sizes;
+        const char *iter = arg;
+        while (*iter)
+        {
+            char *end = nullptr;
+            unsigned long long size = strtoull(iter, &end, 10);
+            if (end == iter)
+            {
+                throw std::runtime_error(std::string("Invalid size list: ") + arg);
+            }
+            sizes.push_back((size_t)size);
+            iter = (*end == ',') ? end + 1 : end;
+        }
+        return sizes;
+    }
+
+    Options parse_options(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool has_value = (i + 1 < argc);
+            if (arg == "--sizes" && has_value)
+            {
+                options.sizes = parse_sizes(argv[++i]);
+            }
+            else if (arg == "--repetitions" && has_value)
+            {
+                options.repetitions = atoi(argv[++i]);
+                if (options.repetitions < 1)
+                {
+                    options.repetitions = 1;
+                }
+            }
+            else if (arg == "--threads" && has_value)
+            {
+                options.num_threads = (unsigned)atoi(argv[++i]);
+            }
+            else if (arg == "--dir" && has_value)
+            {
+                options.dir = argv[++i];
+            }
+            else if (arg == "--json" && has_value)
+            {
+                options.json_path = argv[++i];
+            }
+            else if (arg == "--max-memory" && has_value)
+            {
+                options.max_memory = strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+            }
+            else if (arg == "--keep")
+            {
+                options.keep_files = true;
+            }
+            else
+            {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        return options;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        Options options = parse_options(argc, argv);
+        Runner runner(options);
+        for (size_t size : options.sizes)
+        {
+            bench_size(runner, options, size);
+        }
+
+        if (!options.json_path.empty())
+        {
+            runner.write_json(options.json_path);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        fprintf(stderr, "tiny_stl_bench: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+// Offset of the "facet normal" line of facet index in ASCII text
+static size_t find_facet(const std::string &content, size_t index)
+{
+    size_t offset = content.find("facet normal");
+    for (size_t i = 0; i < index && offset != std::string::npos; i++)
+    {
+        offset = content.find("facet normal", offset + 1);
+    }
+    return offset;
+}
+
+// Parsing with any number of threads, or through a small stream window, must return exactly what serial parsing returns
+static void check_same_as_serial(const std::string &content)
+{
+    Tiny_STL::Reader_Options options;
+    auto reader = Tiny_STL::create_reader(content.data(), content.size(), options);
+    const std::vector<Tiny_STL::Triangle> serial = read_all(reader.get());
+
+    const std::string path = "ascii_parallel.stl";
+    write_file(path, content);
+    options.stream_window_size = 4096;
+    reader = Tiny_STL::create_reader(path.c_str(), options);
+    CHECK(same_triangles(read_all(reader.get()), serial));
+    options.stream_window_size = 0;
+    remove(path.c_str());
+
+    const unsigned thread_counts[] = {2, 3, 8};
+    for (unsigned num_threads : thread_counts)
+    {
+        options.num_threads = num_threads;
+        reader = Tiny_STL::create_reader(content.data(), content.size(), options);
+        CHECK(same_triangles(read_all(reader.get()), serial));
+    }
+}
+
+int main()
+{
+    // Large enough to be split into several chunks
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(20000);
+    std::vector<char> buffer;
+    {
+        auto writer = Tiny_STL::create_writer(&buffer, Tiny_STL::File_Writer::Type::ASCII);
+        writer->write_triangles(triangles.data(), triangles.size());
+    }
+    const std::string content(buffer.begin(), buffer.end());
+
+    check_same_as_serial(content);
+
+    const size_t positions[] = {100, triangles.size() / 2, triangles.size() - 100};
+    for (size_t position : positions)
+    {
+        const size_t facet = find_facet(content, position);
+
+        // Missing normal
+        std::string malformed = content;
+        malformed.replace(content.find("normal", facet), 6, "xxxxxx");
+        check_same_as_serial(malformed);
+
+        // Missing vertex
+        malformed = content;
+        malformed.replace(content.find("vertex", facet), 6, "xxxxxx");
+        check_same_as_serial(malformed);
+
+        // Extra vertex
+        malformed = content;
+        malformed.insert(content.find("endloop", facet), "vertex 1 2 3\n");
+        check_same_as_serial(malformed);
+
+        // Truncated
+        check_same_as_serial(content.substr(0, facet + 40));
+    }
+
+    return test_result();
+}
@@ -0,0 +1,91 @@
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define TEST_HAS_FIFO 1
+#else
+#define TEST_HAS_FIFO 0
+#endif
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "ascii_stream.stl";
+
+static std::vector<Tiny_STL::Triangle> read_stream(const std::string &path, size_t window_size)
+{
+    Tiny_STL::Reader_Options options;
+    options.stream_window_size = window_size;
+    auto reader = Tiny_STL::create_reader(path.c_str(), options);
+    return read_all(reader.get());
+}
+
+// Facets longer than the window make it grow instead of being cut
+static void test_window_growth()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(100);
+    std::string content = write_to_string(File_Writer::Type::ASCII, triangles);
+
+    const size_t positions[] = {content.find("outer loop"), content.rfind("vertex"), content.find("endloop", content.size() / 2)};
+    for (size_t position : positions)
+    {
+        content.insert(position, std::string(3 * 4096, ' '));
+    }
+    write_file(PATH, content);
+
+    const size_t window_sizes[] = {1, 4096, 5000, 1024 * 1024};
+    for (size_t window_size : window_sizes)
+    {
+        CHECK(same_triangles(read_stream(PATH, window_size), triangles));
+    }
+}
+
+#if TEST_HAS_FIFO
+// A named pipe cannot be seeked or mapped, so both formats are read by the stream readers
+static void test_pipe()
+{
+    const std::string fifo_path = "ascii_stream.fifo";
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(20000);
+    const File_Writer::Type types[] = {File_Writer::Type::BINARY, File_Writer::Type::ASCII};
+    for (File_Writer::Type type : types)
+    {
+        const std::string content = write_to_string(type, triangles);
+        remove(fifo_path.c_str());
+        if (mkfifo(fifo_path.c_str(), 0600) != 0)
+        {
+            fprintf(stderr, "Failed to create %s\n", fifo_path.c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            FILE *file = fopen(fifo_path.c_str(), "wb");
+            bool success = file != nullptr && fwrite(content.data(), 1, content.size(), file) == content.size();
+            success = file != nullptr && fclose(file) == 0 && success;
+            _exit(success ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        CHECK(same_triangles(read_stream(fifo_path, 4096), triangles));
+        int status = 0;
+        waitpid(pid, &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    }
+    remove(fifo_path.c_str());
+}
+#endif
+
+int main()
+{
+    test_window_growth();
+#if TEST_HAS_FIFO
+    test_pipe();
+#endif
+    remove(PATH.c_str());
+    return test_result();
+}
@@ -0,0 +1,83 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "binary_attributes.stl";
+static const std::string CONVERTED_PATH = "binary_attributes_converted.stl";
+
+static std::vector<uint16_t> make_attributes(size_t count)
+{
+    std::vector<uint16_t> attributes(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        attributes[i] = (uint16_t)(i * 7919 + 1);
+    }
+    return attributes;
+}
+
+// Reads in batches that do not line up with the readers' internal chunks
+static void check_reader(Tiny_STL::File_Reader *reader, const std::vector<Tiny_STL::Triangle> &expected,
+                         const std::vector<uint16_t> &expected_attributes)
+{
+    constexpr size_t BATCH_SIZE = 1000;
+    std::vector<Tiny_STL::Triangle> triangles;
+    std::vector<uint16_t> attributes;
+    while (true)
+    {
+        size_t size = triangles.size();
+        triangles.resize(size + BATCH_SIZE);
+        attributes.resize(size + BATCH_SIZE);
+        size_t count = reader->read_triangles_with_attributes(triangles.data() + size, attributes.data() + size, BATCH_SIZE);
+        triangles.resize(size + count);
+        attributes.resize(size + count);
+        if (count == 0)
+        {
+            break;
+        }
+    }
+    CHECK(same_triangles(triangles, expected));
+    CHECK(attributes == expected_attributes);
+}
+
+static void check_file(const std::string &path, const std::vector<Tiny_STL::Triangle> &expected, const std::vector<uint16_t> &expected_attributes)
+{
+    Tiny_STL::Reader_Options options;
+    check_reader(Tiny_STL::create_reader(path.c_str(), options).get(), expected, expected_attributes);
+
+    options.use_mmap = false;
+    check_reader(Tiny_STL::create_reader(path.c_str(), options).get(), expected, expected_attributes);
+
+    // Falls back to stdio when the library was built without liburing
+    options.use_io_uring = true;
+    check_reader(Tiny_STL::create_reader(path.c_str(), options).get(), expected, expected_attributes);
+}
+
+int main()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(5000);
+    const std::vector<uint16_t> attributes = make_attributes(triangles.size());
+
+    std::vector<char> buffer;
+    {
+        auto writer = Tiny_STL::create_writer(&buffer, File_Writer::Type::BINARY);
+        writer->write_triangles_with_attributes(triangles.data(), attributes.data(), triangles.size());
+    }
+    write_file(PATH, std::string(buffer.begin(), buffer.end()));
+
+    check_file(PATH, triangles, attributes);
+
+    Tiny_STL::Reader_Options options;
+    options.num_threads = 2;
+    check_reader(Tiny_STL::create_reader(buffer.data(), buffer.size(), options).get(), triangles, attributes);
+
+    Tiny_STL::convert(PATH.c_str(), CONVERTED_PATH.c_str(), File_Writer::Type::BINARY);
+    check_file(CONVERTED_PATH, triangles, attributes);
+
+    remove(PATH.c_str());
+    remove(CONVERTED_PATH.c_str());
+    return test_result();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tiny_stl.hpp"
+
+// Minimal checks without a test framework, a test executable fails when any check failed
+
+static int g_num_failures = 0;
+
+#define CHECK(condition)                                                                   \
+    do                                                                                     \
+    {                                                                                      \
+        if (!(condition))                                                                  \
+        {                                                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_num_failures++;                                                              \
+        }                                                                                  \
+    } while (false)
+
+static inline int test_result()
+{
+    if (g_num_failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", g_num_failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static inline void write_file(const std::string &path, const std::string &content)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to create %s\n", path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+}
+
+// Writes triangles to memory and returns the complete file content
+static inline std::string write_to_string(Tiny_STL::File_Writer::Type type, const std::vector<Tiny_STL::Triangle> &triangles,
+                                          const Tiny_STL::Writer_Options &options = Tiny_STL::Writer_Options())
+{
+    std::vector<char> buffer;
+    {
+        auto writer = Tiny_STL::create_writer(&buffer, type, options);
+        writer->write_triangles(triangles.data(), triangles.size());
+    }
+    return std::string(buffer.begin(), buffer.end());
+}
+
+static inline std::vector<Tiny_STL::Triangle> read_all(Tiny_STL::File_Reader *reader)
+{
+    std::vector<Tiny_STL::Triangle> triangles;
+    Tiny_STL::Triangle t;
+    while (reader->read_next_triangle(&t))
+    {
+        triangles.push_back(t);
+    }
+    return triangles;
+}
+
+// Distinct, exactly representable coordinates, so triangles can be compared bitwise after a round trip
+static inline std::vector<Tiny_STL::Triangle> make_triangles(size_t count)
+{
+    std::vector<Tiny_STL::Triangle> triangles(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            triangles[i].normal[axis] = (float)axis - 1.0f;
+            for (int v = 0; v < 3; v++)
+            {
+                triangles[i].vertices[v][axis] = (float)(i % 1000) * 0.5f + (float)(v * 3 + axis);
+            }
+        }
+    }
+    return triangles;
+}
+
+static inline bool same_triangles(const std::vector<Tiny_STL::Triangle> &a, const std::vector<Tiny_STL::Triangle> &b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(Tiny_STL::Triangle)) == 0);
+}
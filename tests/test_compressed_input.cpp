@@ -0,0 +1,142 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if TINY_STL_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#if TINY_STL_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "compressed_input.stl";
+
+// Reads compressed through a file and checks that it decompresses to expected
+static void check_round_trip(const std::string &compressed, const std::vector<Tiny_STL::Triangle> &expected)
+{
+    write_file(PATH, compressed);
+    auto reader = Tiny_STL::create_reader(PATH.c_str());
+    CHECK(same_triangles(read_all(reader.get()), expected));
+    CHECK(Tiny_STL::count_triangles(PATH.c_str()) == expected.size());
+    CHECK(Tiny_STL::probe(PATH.c_str()).compressed);
+}
+
+// Truncated input must be reported instead of silently returning fewer triangles
+static void check_truncated(const std::string &compressed)
+{
+    write_file(PATH, compressed.substr(0, compressed.size() / 2));
+    bool threw = false;
+    try
+    {
+        auto reader = Tiny_STL::create_reader(PATH.c_str());
+        read_all(reader.get());
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Round trips, content split into two parts that are compressed separately and concatenated,
+// which must decompress to the concatenation of both, and truncation
+template <typename Compress>
+static void test_compression(Compress &&compress)
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(20000);
+    const File_Writer::Type types[] = {File_Writer::Type::BINARY, File_Writer::Type::ASCII};
+    for (File_Writer::Type type : types)
+    {
+        const std::string content = write_to_string(type, triangles);
+        const std::string compressed = compress(content);
+        check_round_trip(compressed, triangles);
+
+        // Split inside the detection sample and far after it
+        const size_t splits[] = {50, content.size() / 3};
+        for (size_t split : splits)
+        {
+            check_round_trip(compress(content.substr(0, split)) + compress(content.substr(split)), triangles);
+        }
+
+        check_truncated(compressed);
+    }
+}
+
+#if TINY_STL_HAS_ZLIB
+static std::string gzip_compress(const std::string &data)
+{
+    z_stream stream{};
+    // 15 + 16: gzip wrapper with the largest window
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("Failed to initialize zlib");
+    }
+    std::string out(deflateBound(&stream, (uLong)data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = (uInt)data.size();
+    stream.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    stream.avail_out = (uInt)out.size();
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END)
+    {
+        throw std::runtime_error("Failed to compress");
+    }
+    return out;
+}
+#endif
+
+#if TINY_STL_HAS_ZSTD
+static std::string zstd_compress(const std::string &data)
+{
+    std::string out(ZSTD_compressBound(data.size()), '\0');
+    size_t size = ZSTD_compress(&out[0], out.size(), data.data(), data.size(), 3);
+    if (ZSTD_isError(size))
+    {
+        throw std::runtime_error("Failed to compress");
+    }
+    out.resize(size);
+    return out;
+}
+#endif
+
+// Without support built in, compressed files are rejected instead of being parsed as STL
+static void check_unsupported(const std::string &magic)
+{
+    write_file(PATH, magic + std::string(200, 'x'));
+    bool threw = false;
+    try
+    {
+        Tiny_STL::create_reader(PATH.c_str());
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main()
+{
+#if TINY_STL_HAS_ZLIB
+    test_compression(gzip_compress);
+#else
+    check_unsupported("\x1f\x8b");
+#endif
+
+#if TINY_STL_HAS_ZSTD
+    test_compression(zstd_compress);
+#else
+    check_unsupported("\x28\xb5\x2f\xfd");
+#endif
+
+    remove(PATH.c_str());
+    return test_result();
+}
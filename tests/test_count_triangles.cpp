@@ -0,0 +1,51 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "count_triangles.stl";
+
+// Files are counted in 1MB blocks, keywords repeat every 9 bytes here,
+// so across the shifts every split of "endfacet" lands on a block boundary
+static void test_keywords_across_blocks()
+{
+    const size_t num_keywords = 3 * 1024 * 1024 / 9;
+    std::string keywords;
+    keywords.reserve(num_keywords * 9);
+    for (size_t i = 0; i < num_keywords; i++)
+    {
+        keywords += "endfacet\n";
+    }
+
+    for (size_t shift = 0; shift < 9; shift++)
+    {
+        const std::string content = "solid blocks\n" + std::string(shift, ' ') + keywords + "endsolid blocks\n";
+        write_file(PATH, content);
+        CHECK(Tiny_STL::count_triangles(PATH.c_str()) == num_keywords);
+        CHECK(Tiny_STL::count_triangles(content.data(), content.size()) == num_keywords);
+    }
+}
+
+static void test_written_files()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(12345);
+    const File_Writer::Type types[] = {File_Writer::Type::BINARY, File_Writer::Type::ASCII};
+    for (File_Writer::Type type : types)
+    {
+        const std::string content = write_to_string(type, triangles);
+        write_file(PATH, content);
+        CHECK(Tiny_STL::count_triangles(PATH.c_str()) == triangles.size());
+        CHECK(Tiny_STL::count_triangles(content.data(), content.size()) == triangles.size());
+    }
+}
+
+int main()
+{
+    test_keywords_across_blocks();
+    test_written_files();
+    remove(PATH.c_str());
+    return test_result();
+}
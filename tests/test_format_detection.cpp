@@ -0,0 +1,74 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+// Checks that content is detected as type and read back as expected, from a file and from memory
+static void check_detection(const std::string &content, File_Writer::Type type, const std::vector<Tiny_STL::Triangle> &expected)
+{
+    const std::string path = "format_detection.stl";
+    write_file(path, content);
+
+    CHECK(Tiny_STL::read_header(path.c_str()).type == type);
+    CHECK(Tiny_STL::read_header(content.data(), content.size()).type == type);
+
+    auto reader = Tiny_STL::create_reader(path.c_str());
+    CHECK(same_triangles(read_all(reader.get()), expected));
+    reader = Tiny_STL::create_reader(content.data(), content.size());
+    CHECK(same_triangles(read_all(reader.get()), expected));
+
+    remove(path.c_str());
+}
+
+static void test_ascii_with_utf8_name()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(3);
+    Tiny_STL::Writer_Options options;
+    options.solid_name = "Bauteil_\xc3\xa4\xc3\xb6\xc3\xbc";
+    const std::string content = write_to_string(File_Writer::Type::ASCII, triangles, options);
+
+    check_detection(content, File_Writer::Type::ASCII, triangles);
+    CHECK(Tiny_STL::read_header(content.data(), content.size()).solid_name == options.solid_name);
+}
+
+static void test_ascii_without_lowercase_solid()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(3);
+    std::string content = write_to_string(File_Writer::Type::ASCII, triangles, Tiny_STL::Writer_Options());
+    content.replace(0, 5, "SOLID");
+    check_detection(content, File_Writer::Type::ASCII, triangles);
+
+    // A stray control character in the name does not make the file binary
+    content.replace(0, 5, "solid\x01");
+    check_detection(content, File_Writer::Type::ASCII, triangles);
+}
+
+static void test_binary_with_solid_header()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(3);
+    unsigned char header[80];
+    memset(header, ' ', sizeof(header));
+    memcpy(header, "solid part", 10);
+    Tiny_STL::Writer_Options options;
+    options.binary_header = header;
+    std::string content = write_to_string(File_Writer::Type::BINARY, triangles, options);
+
+    check_detection(content, File_Writer::Type::BINARY, triangles);
+
+    // Trailing padding, the file size no longer matches the header count
+    content.append(37, ' ');
+    check_detection(content, File_Writer::Type::BINARY, triangles);
+    content.append(100, '\0');
+    check_detection(content, File_Writer::Type::BINARY, triangles);
+}
+
+int main()
+{
+    test_ascii_with_utf8_name();
+    test_ascii_without_lowercase_solid();
+    test_binary_with_solid_header();
+    return test_result();
+}
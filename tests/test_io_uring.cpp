@@ -0,0 +1,71 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "io_uring.stl";
+
+static std::unique_ptr<Tiny_STL::File_Reader> create_uring_reader()
+{
+    Tiny_STL::Reader_Options options;
+    options.use_io_uring = true;
+    auto reader = Tiny_STL::create_reader(PATH.c_str(), options);
+#if TINY_STL_HAS_IO_URING
+    // The io_uring reader is the only binary file reader without random access
+    CHECK(dynamic_cast<Tiny_STL::Random_Access_Reader *>(reader.get()) == nullptr);
+#endif
+    return reader;
+}
+
+// Mixes batch and single triangle reads, batches do not line up with the reader's blocks
+static std::vector<Tiny_STL::Triangle> read_mixed(Tiny_STL::File_Reader *reader)
+{
+    constexpr size_t BATCH_SIZE = 7777;
+    std::vector<Tiny_STL::Triangle> triangles;
+    while (true)
+    {
+        size_t size = triangles.size();
+        triangles.resize(size + BATCH_SIZE);
+        size_t count = reader->read_triangles(triangles.data() + size, BATCH_SIZE);
+        triangles.resize(size + count);
+        Tiny_STL::Triangle t;
+        if (count == 0 || !reader->read_next_triangle(&t))
+        {
+            break;
+        }
+        triangles.push_back(t);
+    }
+    return triangles;
+}
+
+int main()
+{
+    // More records than the blocks in flight hold at once, so blocks are reused
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(150000);
+    std::string content = write_to_string(File_Writer::Type::BINARY, triangles);
+
+    write_file(PATH, content);
+    CHECK(same_triangles(read_mixed(create_uring_reader().get()), triangles));
+    CHECK(same_triangles(read_all(create_uring_reader().get()), triangles));
+
+    // Records past the header count are not read
+    const std::vector<Tiny_STL::Triangle> first(triangles.begin(), triangles.begin() + 100000);
+    const uint32_t header_count = (uint32_t)first.size();
+    memcpy(&content[80], &header_count, sizeof(header_count));
+    write_file(PATH, content);
+    CHECK(same_triangles(read_mixed(create_uring_reader().get()), first));
+
+    // Readers destroyed with reads still in flight
+    for (size_t i = 0; i < 10; i++)
+    {
+        auto reader = create_uring_reader();
+        Tiny_STL::Triangle t;
+        CHECK(reader->read_next_triangle(&t));
+    }
+
+    remove(PATH.c_str());
+    return test_result();
+}
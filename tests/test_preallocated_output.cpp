@@ -0,0 +1,118 @@
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/resource.h>
+#define TEST_HAS_RLIMIT 1
+#else
+#define TEST_HAS_RLIMIT 0
+#endif
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "preallocated_output.stl";
+
+static uint64_t file_size(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return (size > 0) ? (uint64_t)size : 0;
+}
+
+static uint32_t header_count(const std::string &path)
+{
+    uint32_t count = 0;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file != nullptr)
+    {
+        fseek(file, 80, SEEK_SET);
+        if (fread(&count, sizeof(count), 1, file) != 1)
+        {
+            count = 0;
+        }
+        fclose(file);
+    }
+    return count;
+}
+
+// Writes triangles to a file preallocated for expected_count triangles
+static void write_preallocated(const std::vector<Tiny_STL::Triangle> &triangles, size_t expected_count)
+{
+    Tiny_STL::Writer_Options options;
+    options.triangle_count = expected_count;
+    auto writer = Tiny_STL::create_writer(PATH.c_str(), File_Writer::Type::BINARY, options);
+    writer->write_triangles(triangles.data(), triangles.size());
+}
+
+static void check_file(const std::vector<Tiny_STL::Triangle> &expected)
+{
+    CHECK(file_size(PATH) == 84 + expected.size() * 50);
+    CHECK(header_count(PATH) == expected.size());
+    auto reader = Tiny_STL::create_reader(PATH.c_str());
+    CHECK(same_triangles(read_all(reader.get()), expected));
+}
+
+// The header count is patched while the header is still in the output buffer (small files),
+// and after the header was flushed while the last records are still buffered (over 8MB),
+// space preallocated for triangles that were never written is truncated
+static void test_count_mismatch()
+{
+    const size_t sizes[] = {10, 200000};
+    for (size_t size : sizes)
+    {
+        const std::vector<Tiny_STL::Triangle> triangles = make_triangles(size);
+
+        write_preallocated(triangles, size);
+        check_file(triangles);
+
+        write_preallocated(triangles, size + 1000);
+        check_file(triangles);
+
+        write_preallocated(triangles, size / 2);
+        check_file(triangles);
+    }
+}
+
+#if TEST_HAS_RLIMIT
+// Records that fail to reach the file must not be counted in the header
+static void test_write_failure()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(200000);
+
+    // Writes past the limit fail with EFBIG instead of raising SIGXFSZ
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit original;
+    getrlimit(RLIMIT_FSIZE, &original);
+    rlimit limited = original;
+    limited.rlim_cur = 84 + 1000 * 50 + 17;
+    setrlimit(RLIMIT_FSIZE, &limited);
+
+    write_preallocated(triangles, triangles.size());
+
+    setrlimit(RLIMIT_FSIZE, &original);
+
+    CHECK(header_count(PATH) == 1000);
+    auto reader = Tiny_STL::create_reader(PATH.c_str());
+    CHECK(same_triangles(read_all(reader.get()), std::vector<Tiny_STL::Triangle>(triangles.begin(), triangles.begin() + 1000)));
+}
+#endif
+
+int main()
+{
+    test_count_mismatch();
+#if TEST_HAS_RLIMIT
+    test_write_failure();
+#endif
+    remove(PATH.c_str());
+    return test_result();
+}
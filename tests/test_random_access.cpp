@@ -0,0 +1,70 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "random_access.stl";
+
+static bool same_range(const std::vector<Tiny_STL::Triangle> &triangles, size_t first, const Tiny_STL::Triangle *range, size_t count)
+{
+    return count == 0 || memcmp(triangles.data() + first, range, count * sizeof(Tiny_STL::Triangle)) == 0;
+}
+
+static void check_reader(Tiny_STL::Random_Access_Reader *reader, const std::vector<Tiny_STL::Triangle> &triangles)
+{
+    const size_t size = triangles.size();
+    CHECK(reader->triangle_count() == size);
+
+    std::vector<Tiny_STL::Triangle> range(size + 10);
+
+    // Inside, touching the end, past the end and empty ranges
+    CHECK(reader->read_range(10, 300, range.data()) == 300);
+    CHECK(same_range(triangles, 10, range.data(), 300));
+    CHECK(reader->read_range(size - 5, 5, range.data()) == 5);
+    CHECK(same_range(triangles, size - 5, range.data(), 5));
+    CHECK(reader->read_range(size - 5, 10, range.data()) == 5);
+    CHECK(same_range(triangles, size - 5, range.data(), 5));
+    CHECK(reader->read_range(0, size + 10, range.data()) == size);
+    CHECK(same_range(triangles, 0, range.data(), size));
+    CHECK(reader->read_range(size, 1, range.data()) == 0);
+    CHECK(reader->read_range(size + 100, 1, range.data()) == 0);
+    CHECK(reader->read_range(3, 0, range.data()) == 0);
+
+    // Ranges read between sequential reads do not move the sequential position
+    std::vector<Tiny_STL::Triangle> sequential(size);
+    size_t count = reader->read_triangles(sequential.data(), 100);
+    CHECK(reader->read_range(size - 300, 300, range.data()) == 300);
+    Tiny_STL::Triangle t;
+    while (count < size && reader->read_next_triangle(&t))
+    {
+        sequential[count++] = t;
+        if (count % 500 == 0)
+        {
+            CHECK(reader->read_range(0, 1, range.data()) == 1);
+        }
+    }
+    CHECK(count == size);
+    CHECK(!reader->read_next_triangle(&t));
+    CHECK(same_triangles(sequential, triangles));
+}
+
+int main()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(2000);
+
+    // Trailing padding after the records is not part of the triangle count
+    std::string content = write_to_string(File_Writer::Type::BINARY, triangles);
+    content.append(120, '\0');
+    write_file(PATH, content);
+
+    Tiny_STL::Reader_Options options;
+    check_reader(Tiny_STL::create_random_access_reader(PATH.c_str(), options).get(), triangles);
+    options.use_mmap = false;
+    check_reader(Tiny_STL::create_random_access_reader(PATH.c_str(), options).get(), triangles);
+
+    remove(PATH.c_str());
+    return test_result();
+}
@@ -0,0 +1,95 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
+
+using Tiny_STL::File_Writer;
+
+static const std::string PATH = "static.stl";
+
+template <File_Writer::Type TYPE>
+static std::vector<Tiny_STL::Triangle> read_static(Tiny_STL::Static_Reader<TYPE> &reader)
+{
+    std::vector<Tiny_STL::Triangle> triangles;
+    reader.for_each_triangle([&](const Tiny_STL::Triangle &t) { triangles.push_back(t); });
+    return triangles;
+}
+
+template <typename Function>
+static bool throws(Function &&function)
+{
+    try
+    {
+        function();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+// Written by the static writer over more than one batch, read by the static and the regular readers
+template <File_Writer::Type TYPE>
+static void test_round_trip()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(10000);
+    Tiny_STL::Writer_Options options;
+    options.solid_name = "part";
+
+    std::vector<char> buffer;
+    {
+        Tiny_STL::Static_Writer<TYPE> writer(&buffer, options);
+        for (const Tiny_STL::Triangle &t : triangles)
+        {
+            writer.write_triangle(t);
+        }
+        writer.close();
+    }
+    CHECK(Tiny_STL::read_header(buffer.data(), buffer.size()).solid_name == options.solid_name);
+    Tiny_STL::Static_Reader<TYPE> memory_reader(buffer.data(), buffer.size());
+    CHECK(same_triangles(read_static(memory_reader), triangles));
+
+    {
+        Tiny_STL::Static_Writer<TYPE> writer(PATH.c_str(), options);
+        for (const Tiny_STL::Triangle &t : triangles)
+        {
+            writer.write_triangle(t);
+        }
+    }
+    Tiny_STL::Static_Reader<TYPE> file_reader(PATH.c_str());
+    CHECK(same_triangles(read_static(file_reader), triangles));
+    auto reader = Tiny_STL::create_reader(PATH.c_str());
+    CHECK(same_triangles(read_all(reader.get()), triangles));
+}
+
+static void test_format_mismatch()
+{
+    const std::vector<Tiny_STL::Triangle> triangles = make_triangles(10);
+    const std::string ascii = write_to_string(File_Writer::Type::ASCII, triangles);
+    const std::string binary = write_to_string(File_Writer::Type::BINARY, triangles);
+
+    CHECK(throws([&] { Tiny_STL::Static_Binary_Reader reader(ascii.data(), ascii.size()); }));
+    CHECK(throws([&] { Tiny_STL::Static_ASCII_Reader reader(binary.data(), binary.size()); }));
+
+    write_file(PATH, ascii);
+    CHECK(throws([&] { Tiny_STL::Static_Binary_Reader reader(PATH.c_str()); }));
+    write_file(PATH, binary);
+    CHECK(throws([&] { Tiny_STL::Static_ASCII_Reader reader(PATH.c_str()); }));
+
+    // Recognized as gzip from its magic bytes, whether or not gzip input is supported
+    write_file(PATH, std::string("\x1f\x8b\x08\x00", 4) + binary);
+    CHECK(throws([&] { Tiny_STL::Static_Binary_Reader reader(PATH.c_str()); }));
+}
+
+int main()
+{
+    test_round_trip<File_Writer::Type::BINARY>();
+    test_round_trip<File_Writer::Type::ASCII>();
+    test_format_mismatch();
+    remove(PATH.c_str());
+    return test_result();
+}
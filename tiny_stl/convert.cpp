@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "non_copyable.hpp"
+#include "parallel.hpp"
+#include "tiny_stl.hpp"
+
+namespace Tiny_STL
+{
+    // Triangles per buffer handed from the reading stage to the writing stage, per reader or writer thread,
+    // so that parallel binary decoding and ASCII formatting get batches large enough to be split
+    static constexpr size_t CONVERT_BLOCK_SIZE = 64 * 1024;
+    // Limits the size of the buffers (50 bytes per triangle) with many threads
+    static constexpr unsigned MAX_CONVERT_BLOCKS = 8;
+
+    static size_t convert_block_size(const Reader_Options &reader_options, const Writer_Options &writer_options)
+    {
+        unsigned num_threads = std::max(resolve_num_threads(reader_options.num_threads), resolve_num_threads(writer_options.num_threads));
+        return CONVERT_BLOCK_SIZE * std::min(num_threads, MAX_CONVERT_BLOCKS);
+    }
+
+    // Two buffers that alternate between a producer filling them and a consumer draining them
+    class Double_Buffer : public NonCopyable
+    {
+    private:
+        std::vector<Triangle> m_buffers[2];
+        std::vector<uint16_t> m_attributes[2];
+        size_t m_counts[2] = {0, 0};
+        bool m_full[2] = {false, false};
+        bool m_cancelled = false;
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+
+    public:
+        explicit Double_Buffer(size_t block_size)
+        {
+            m_buffers[0].resize(block_size);
+            m_buffers[1].resize(block_size);
+            m_attributes[0].resize(block_size);
+            m_attributes[1].resize(block_size);
+        }
+
+        // Attribute byte counts of the triangles in buffer index, owned by whoever holds the buffer
+        uint16_t *attributes(int index)
+        {
+            return m_attributes[index].data();
+        }
+
+        // Waits until buffer index is free for filling, returns nullptr if the consumer gave up
+        Triangle *acquire_empty(int index)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [&]()
+            {
+                return !m_full[index] || m_cancelled;
+            });
+            return m_cancelled ? nullptr : m_buffers[index].data();
+        }
+
+        // A count of zero marks the end of input
+        void publish(int index, size_t count)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_counts[index] = count;
+                m_full[index] = true;
+            }
+            m_changed.notify_all();
+        }
+
+        const Triangle *acquire_full(int index, size_t *count)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [&]()
+            {
+                return m_full[index];
+            });
+            *count = m_counts[index];
+            return m_buffers[index].data();
+        }
+
+        void release(int index)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_full[index] = false;
+            }
+            m_changed.notify_all();
+        }
+
+        void cancel()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_cancelled = true;
+            }
+            m_changed.notify_all();
+        }
+    };
+
+    void convert(const char *src_filepath, const char *dst_filepath, File_Writer::Type type,
+                 const Reader_Options &reader_options, const Writer_Options &writer_options)
+    {
+        Header header;
+        std::unique_ptr<File_Reader> reader = create_reader(src_filepath, reader_options, &header);
+
+        // Binary sources know their triangle count, which lets binary output be preallocated
+        Writer_Options options = writer_options;
+
+        // Header metadata is carried over unless the caller provides its own,
+        // binary headers only to binary files, as they may hold arbitrary bytes
+        if (options.binary_header == nullptr && options.solid_name.empty())
+        {
+            if (header.type == File_Writer::Type::ASCII)
+            {
+                options.solid_name = header.solid_name;
+            }
+            else if (type == File_Writer::Type::BINARY)
+            {
+                options.binary_header = header.binary;
+            }
+        }
+        const Random_Access_Reader *random_access = dynamic_cast<const Random_Access_Reader *>(reader.get());
+        if (options.triangle_count == 0 && random_access != nullptr)
+        {
+            options.triangle_count = random_access->triangle_count();
+        }
+        std::unique_ptr<File_Writer> writer = create_writer(dst_filepath, type, options);
+
+        const size_t block_size = convert_block_size(reader_options, writer_options);
+        Double_Buffer buffers(block_size);
+        std::exception_ptr read_error;
+
+        // Reading and parsing run on their own thread while the calling thread formats and writes,
+        // so that parsing the next block overlaps writing the current one
+        std::thread read_thread([&]()
+        {
+            try
+            {
+                for (int index = 0;; index ^= 1)
+                {
+                    Triangle *block = buffers.acquire_empty(index);
+                    if (block == nullptr)
+                    {
+                        return;
+                    }
+                    size_t count = reader->read_triangles_with_attributes(block, buffers.attributes(index), block_size);
+                    buffers.publish(index, count);
+                    if (count == 0)
+                    {
+                        return;
+                    }
+                }
+            }
+            catch (...)
+            {
+                read_error = std::current_exception();
+                buffers.publish(0, 0);
+                buffers.publish(1, 0);
+            }
+        });
+
+        try
+        {
+            for (int index = 0;; index ^= 1)
+            {
+                size_t count;
+                const Triangle *block = buffers.acquire_full(index, &count);
+                if (count == 0)
+                {
+                    break;
+                }
+                writer->write_triangles_with_attributes(block, buffers.attributes(index), count);
+                buffers.release(index);
+            }
+        }
+        catch (...)
+        {
+            buffers.cancel();
+            read_thread.join();
+            throw;
+        }
+
+        read_thread.join();
+        if (read_error)
+        {
+            std::rethrow_exception(read_error);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "tiny_stl_static.hpp"
+
+// Tells binary and ASCII files apart from their first bytes only,
+// so that it works without knowing the file size (pipes, streams)
+// and does not need the size to match the header exactly (binary files with trailing padding)
+namespace Format_Detection
+{
+    // Number of leading bytes inspected, header plus the first few binary records
+    static constexpr size_t SAMPLE_SIZE = Tiny_STL::Binary_Record::TRIANGLES_OFFSET + 16 * Tiny_STL::Binary_Record::SIZE;
+
+    // Bytes >= 0x80 count as text, they appear in UTF-8 and Latin-1 solid names
+    static inline bool is_text_byte(unsigned char c)
+    {
+        return c >= 32 || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+    }
+
+    static inline bool is_space(unsigned char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+    }
+
+    // Whether keyword (lowercase) followed by white space occurs in sample, ignoring case
+    static inline bool contains_keyword(const unsigned char *sample, size_t sample_size, const char *keyword)
+    {
+        size_t keyword_size = strlen(keyword);
+        for (size_t i = 0; i + keyword_size < sample_size; i++)
+        {
+            size_t j = 0;
+            while (j < keyword_size && (sample[i + j] | 0x20) == (unsigned char)keyword[j])
+            {
+                j++;
+            }
+            if (j == keyword_size && is_space(sample[i + keyword_size]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Name on the first line of text, after a leading "solid" keyword if there is one,
+    // stops at a line break or NUL byte, so it also extracts names stored in binary headers
+    static inline std::string solid_name(const unsigned char *text, size_t size)
+    {
+        size_t begin = 0;
+        while (begin < size && (text[begin] == ' ' || text[begin] == '\t' || text[begin] == '\r' || text[begin] == '\n'))
+        {
+            begin++;
+        }
+        if (size - begin >= 5 && memcmp(text + begin, "solid", 5) == 0)
+        {
+            begin += 5;
+        }
+        while (begin < size && (text[begin] == ' ' || text[begin] == '\t'))
+        {
+            begin++;
+        }
+
+        size_t end = begin;
+        while (end < size && text[end] != '\n' && text[end] != '\r' && text[end] != '\0')
+        {
+            end++;
+        }
+        while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t'))
+        {
+            end--;
+        }
+        return std::string(reinterpret_cast<const char *>(text + begin), end - begin);
+    }
+
+    static inline uint32_t header_triangle_count(const unsigned char *sample)
+    {
+        uint32_t num_tris = 0;
+        memcpy(&num_tris, sample + Tiny_STL::Binary_Record::HEADER_SIZE, sizeof(uint32_t));
+        return num_tris;
+    }
+
+    // sample holds the first sample_size bytes of the data,
+    // total_size is the size of the whole data or -1 when unknown
+    static inline bool is_binary(const unsigned char *sample, size_t sample_size, int64_t total_size)
+    {
+        if (sample_size < Tiny_STL::Binary_Record::TRIANGLES_OFFSET)
+        {
+            // Too short to hold a binary header
+            return false;
+        }
+
+        uint64_t expected_size = Tiny_STL::Binary_Record::TRIANGLES_OFFSET + (uint64_t)header_triangle_count(sample) * Tiny_STL::Binary_Record::SIZE;
+        if (total_size >= 0 && (uint64_t)total_size == expected_size)
+        {
+            return true;
+        }
+
+        // Binary data is recognized by bytes that cannot appear in text,
+        // which the triangle count and the float records practically always contain
+        bool has_binary_bytes = false;
+        for (size_t i = 0; i < sample_size && !has_binary_bytes; i++)
+        {
+            has_binary_bytes = !is_text_byte(sample[i]);
+        }
+        if (!has_binary_bytes)
+        {
+            return false;
+        }
+
+        // Headers of binary files often start with "solid" too, but the facets of ASCII files
+        // follow right after their first line, so a stray control character does not make text binary
+        return !contains_keyword(sample, sample_size, "facet") && !contains_keyword(sample, sample_size, "endsolid");
+    }
+
+    // Number of triangles of a binary file, the header count when the size is unknown
+    static inline uint64_t binary_triangle_count(const unsigned char *sample, int64_t total_size)
+    {
+        if (total_size < 0)
+        {
+            return header_triangle_count(sample);
+        }
+        return Tiny_STL::Binary_Record::triangle_count(header_triangle_count(sample), (uint64_t)total_size);
+    }
+}
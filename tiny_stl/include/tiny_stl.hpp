@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace Tiny_STL
 {
@@ -11,14 +16,120 @@ namespace Tiny_STL
         float vertices[3][3]{};
     };
 
+    static_assert(sizeof(Triangle) == 12 * sizeof(float), "Triangle must be 12 packed floats");
+
+    // Read-only view of a triangle stored as 12 packed floats (normal, then 3 vertices),
+    // either a binary record inside the reader's buffer or mapping, or a Triangle,
+    // floats may be unaligned so they are only accessed through the accessors
+    class Triangle_View
+    {
+    private:
+        const unsigned char *m_data = nullptr;
+
+        float get(size_t index) const
+        {
+            float value;
+            memcpy(&value, m_data + index * sizeof(float), sizeof(float));
+            return value;
+        }
+
+    public:
+        Triangle_View() = default;
+        explicit Triangle_View(const void *data) : m_data(static_cast<const unsigned char *>(data)) {}
+
+        float normal(int axis) const { return get(axis); }
+        float vertex(int index, int axis) const { return get(3 + index * 3 + axis); }
+
+        Triangle triangle() const
+        {
+            Triangle t;
+            memcpy(t.normal, m_data, sizeof(float[3]));
+            memcpy(t.vertices, m_data + sizeof(float[3]), sizeof(float[3][3]));
+            return t;
+        }
+    };
+
     class File_Reader
     {
+    private:
+        // Triangles that views point to when the reader cannot point into its own buffer
+        std::vector<Triangle> m_view_storage;
+
     public:
         // NOTE: Abstract class destructor must be virtual,
         // otherwise, subclasses' destructors won't be called :/
         // https://stackoverflow.com/a/25220259/8094047
         virtual ~File_Reader() = default;
         virtual bool read_next_triangle(Triangle *t) = 0;
+        // Reads up to max_count triangles into out, returns number of triangles read,
+        // which is less than max_count only when the end of the file is reached,
+        // the library's readers override it to read whole batches at once
+        virtual size_t read_triangles(Triangle *out, size_t max_count)
+        {
+            size_t count = 0;
+            while ((count < max_count) && read_next_triangle(out + count))
+            {
+                count++;
+            }
+            return count;
+        }
+
+        // Like read_triangles but also stores the 16 bit "attribute byte count" of each binary triangle,
+        // which some programs use for per-facet color, into attributes (which can be nullptr),
+        // attributes are 0 for ASCII files
+        virtual size_t read_triangles_with_attributes(Triangle *out, uint16_t *attributes, size_t max_count)
+        {
+            size_t count = read_triangles(out, max_count);
+            if (attributes != nullptr)
+            {
+                memset(attributes, 0, count * sizeof(uint16_t));
+            }
+            return count;
+        }
+
+        // Like read_triangles but fills views instead of copying triangles,
+        // views stay valid until the next call on the reader,
+        // readers of memory and memory mapped binary files point views directly at the records
+        virtual size_t read_views(Triangle_View *out, size_t max_count)
+        {
+            m_view_storage.resize(max_count);
+            size_t count = read_triangles(m_view_storage.data(), max_count);
+            for (size_t i = 0; i < count; i++)
+            {
+                out[i] = Triangle_View(&m_view_storage[i]);
+            }
+            return count;
+        }
+    };
+
+    // Calls fn(const Triangle_View &) for each remaining triangle of reader without copying triangles
+    // when the reader supports it, views are only valid during the call, returns number of triangles visited
+    template <typename Fn>
+    size_t for_each_triangle(File_Reader *reader, Fn &&fn)
+    {
+        constexpr size_t BATCH_SIZE = 256;
+        Triangle_View views[BATCH_SIZE];
+        size_t total = 0;
+        size_t count;
+        while ((count = reader->read_views(views, BATCH_SIZE)) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                fn(static_cast<const Triangle_View &>(views[i]));
+            }
+            total += count;
+        }
+        return total;
+    }
+
+    // Reader for binary files that can also read arbitrary ranges of triangles
+    class Random_Access_Reader : public File_Reader
+    {
+    public:
+        virtual size_t triangle_count() const = 0;
+        // Reads up to count triangles starting at index first into out, returns number of triangles read,
+        // does not change the position used by read_next_triangle and read_triangles
+        virtual size_t read_range(size_t first, size_t count, Triangle *out) = 0;
     };
 
     class File_Writer
@@ -32,8 +143,140 @@ namespace Tiny_STL
 
         virtual ~File_Writer() = default;
         virtual void write_triangle(const Triangle *t) = 0;
+        // Writes count triangles stored contiguously starting at t,
+        // the library's writers override it to write whole batches at once
+        virtual void write_triangles(const Triangle *t, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                write_triangle(t + i);
+            }
+        }
+
+        // Like write_triangles but also writes the attribute byte count of each triangle from attributes,
+        // ignored by ASCII files, which cannot store it
+        virtual void write_triangles_with_attributes(const Triangle *t, const uint16_t *attributes, size_t count)
+        {
+            (void)attributes;
+            write_triangles(t, count);
+        }
+    };
+
+    struct Reader_Options
+    {
+        // Decode binary files from a memory mapping instead of stdio calls,
+        // ignored on platforms without mmap
+        bool use_mmap = true;
+
+        // Number of threads used to parse ASCII files and to decode large batches
+        // from memory mapped binary files, 0 uses all hardware threads,
+        // binary batches are only split when read_triangles asks for at least 64K triangles per thread
+        unsigned num_threads = 1;
+
+        // When non-zero, ASCII files are parsed through a window of this many bytes
+        // that is refilled from the file, instead of reading the whole file into memory
+        size_t stream_window_size = 0;
+
+        // Read binary files through io_uring with several reads in flight,
+        // ignored unless the library was built with liburing
+        bool use_io_uring = false;
+    };
+
+    std::unique_ptr<File_Reader> create_reader(const char *filepath, const Reader_Options &options = Reader_Options());
+    // Reads from an already open file, which can also be a pipe or stdin,
+    // the reader takes ownership of file and closes it
+    std::unique_ptr<File_Reader> create_reader(FILE *file, const Reader_Options &options = Reader_Options());
+    // Parses STL data in memory without copying it, data must outlive the reader
+    std::unique_ptr<File_Reader> create_reader(const void *data, size_t size, const Reader_Options &options = Reader_Options());
+    // Throws if file is not a binary STL file
+    std::unique_ptr<Random_Access_Reader> create_random_access_reader(const char *filepath, const Reader_Options &options = Reader_Options());
+
+    struct Header
+    {
+        File_Writer::Type type = File_Writer::Type::BINARY;
+        // Raw 80 byte header of binary files, all zero for ASCII files
+        unsigned char binary[80]{};
+        // Name after "solid" on the first line of ASCII files,
+        // for binary files the header text up to its first NUL byte (without a leading "solid")
+        std::string solid_name;
     };
 
-    std::unique_ptr<File_Reader> create_reader(const char *filepath);
-    std::unique_ptr<File_Writer> create_writer(const char *filepath, File_Writer::Type type);
+    // Reads only the leading bytes of the file (its first 84 bytes for binary files)
+    Header read_header(const char *filepath);
+    Header read_header(const void *data, size_t size);
+    // Like create_reader but also fills header, from the same read of the file the reader detects its format from
+    std::unique_ptr<File_Reader> create_reader(const char *filepath, const Reader_Options &options, Header *header);
+
+    struct Probe_Result
+    {
+        // Holds the format
+        Header header;
+        // Size of the file in bytes, -1 when unknown (pipes)
+        int64_t file_size = -1;
+        bool compressed = false;
+        // Binary files store their triangle count, which is exact unless the file is compressed or a pipe,
+        // ASCII counts are estimated from the average facet size at the start of the file,
+        // unless the whole file fits in the probed bytes
+        uint64_t triangle_count = 0;
+        bool triangle_count_is_exact = false;
+    };
+
+    // Inspects a file without parsing it, reads at most its first 64KB
+    Probe_Result probe(const char *filepath);
+
+    // Exact number of triangles, binary files store it in their header,
+    // ASCII files are scanned for "endfacet" keywords without parsing any numbers
+    uint64_t count_triangles(const char *filepath);
+    uint64_t count_triangles(const void *data, size_t size);
+
+    // Mesh with shared vertices, vertices that have bitwise identical coordinates are merged
+    struct Indexed_Mesh
+    {
+        std::vector<float> vertices;   // x, y, z of each unique vertex
+        std::vector<uint32_t> indices; // Three vertex indices per triangle
+        std::vector<float> normals;    // x, y, z of each triangle's normal
+    };
+
+    // Reads all remaining triangles of reader into mesh, replacing its contents
+    void read_indexed_mesh(File_Reader *reader, Indexed_Mesh *mesh);
+
+    // Triangles stored as separate contiguous coordinate arrays (structure of arrays),
+    // vertex v of triangle t is at index t * 3 + v
+    struct SoA_Triangles
+    {
+        std::vector<float> x, y, z;
+        // One entry per triangle, left empty when normals are not requested
+        std::vector<float> normal_x, normal_y, normal_z;
+    };
+
+    // Reads all remaining triangles of reader into out, replacing its contents
+    void read_soa_triangles(File_Reader *reader, SoA_Triangles *out, bool with_normals = true);
+
+    struct Writer_Options
+    {
+        // Number of threads used to format large batches of ASCII triangles, 0 uses all hardware threads
+        unsigned num_threads = 1;
+
+        // When non-zero, the number of triangles that will be written,
+        // binary files are then preallocated and written through a large buffer,
+        // and the header is written once instead of being patched at the end,
+        // create_writer throws if it does not fit in the 32 bit count of binary headers
+        size_t triangle_count = 0;
+
+        // When set, the 80 bytes written as the header of binary files,
+        // otherwise binary headers hold solid_name
+        const unsigned char *binary_header = nullptr;
+
+        // Written after "solid" and "endsolid" in ASCII files, must not contain line breaks
+        std::string solid_name;
+    };
+
+    std::unique_ptr<File_Writer> create_writer(const char *filepath, File_Writer::Type type, const Writer_Options &options = Writer_Options());
+    // Appends to buffer, which is complete only after the writer is destroyed
+    std::unique_ptr<File_Writer> create_writer(std::vector<char> *buffer, File_Writer::Type type, const Writer_Options &options = Writer_Options());
+
+    // Converts src file to dst file of the given type,
+    // reading and writing run concurrently on large blocks of triangles
+    void convert(const char *src_filepath, const char *dst_filepath, File_Writer::Type type,
+                 const Reader_Options &reader_options = Reader_Options(), const Writer_Options &writer_options = Writer_Options());
 }
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "tiny_stl.hpp"
+
+// Readers and writers with the file format fixed at compile time,
+// triangles are handed over by reference without virtual calls,
+// the readers decode in this header so decoding can be inlined into the caller's processing loop
+namespace Tiny_STL
+{
+    // Layout of binary STL files:
+    // 80 bytes header, uint32 number of triangles,
+    // then per triangle: float normal[3], float vertices[3][3], uint16 attribute byte count
+    namespace Binary_Record
+    {
+        constexpr size_t HEADER_SIZE = 80;
+        constexpr size_t TRIANGLES_OFFSET = HEADER_SIZE + sizeof(uint32_t);
+        constexpr size_t SIZE = sizeof(float[3]) + sizeof(float[3][3]) + sizeof(uint16_t);
+
+        static_assert(SIZE == 50, "Unexpected binary triangle size");
+
+        inline void decode(const unsigned char *record, Triangle *res)
+        {
+            memcpy(res->normal, record, sizeof(float[3]));
+            memcpy(res->vertices, record + sizeof(float[3]), sizeof(float[3][3]));
+        }
+
+        inline uint16_t decode_attribute(const unsigned char *record)
+        {
+            uint16_t attribute_byte_count;
+            memcpy(&attribute_byte_count, record + sizeof(float[3]) + sizeof(float[3][3]), sizeof(uint16_t));
+            return attribute_byte_count;
+        }
+
+        // Decodes count consecutive records, attributes may be nullptr when they are not wanted
+        inline void decode_records(const unsigned char *records, size_t count, Triangle *out, uint16_t *attributes)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                decode(records + i * SIZE, out + i);
+            }
+            if (attributes != nullptr)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    attributes[i] = decode_attribute(records + i * SIZE);
+                }
+            }
+        }
+
+        // Number of triangles of binary data of data_size bytes whose header stores header_count,
+        // records after the header count (trailing padding) are not triangles,
+        // and a header count larger than the data is limited to the records it holds
+        inline uint64_t triangle_count(uint32_t header_count, uint64_t data_size)
+        {
+            uint64_t available = (data_size > TRIANGLES_OFFSET) ? (data_size - TRIANGLES_OFFSET) / SIZE : 0;
+            return (header_count < available) ? header_count : available;
+        }
+
+        inline void encode(const Triangle *t, uint16_t attribute_byte_count, unsigned char *record)
+        {
+            memcpy(record, t->normal, sizeof(float[3]));
+            memcpy(record + sizeof(float[3]), t->vertices, sizeof(float[3][3]));
+            memcpy(record + sizeof(float[3]) + sizeof(float[3][3]), &attribute_byte_count, sizeof(uint16_t));
+        }
+    }
+
+    // Text parsing costs far more than a call, so it stays in the library
+    namespace ASCII_Facet
+    {
+        // Parses the next facet in [iter, end), advancing iter past its last vertex,
+        // returns false when there is no complete facet left
+        bool parse(const char *&iter, const char *end, Triangle *res);
+    }
+
+    // Contents of a whole file, memory mapped where supported and read into memory elsewhere
+    struct File_Contents
+    {
+        const char *data = nullptr;
+        size_t size = 0;
+        // Owns the mapping, data stays valid as long as it is held
+        std::shared_ptr<const void> storage;
+    };
+
+    // Throws if the file is compressed, not seekable or not an STL file of the given type
+    File_Contents load_file(const char *filepath, File_Writer::Type type);
+
+    // Reads the whole file or buffer as one block, without the streaming, multi-threaded
+    // and io_uring paths of create_reader, in exchange the decode loop lives in this header
+    // and inlines into the caller, records are decoded by the same Binary_Record and ASCII_Facet code
+    template <File_Writer::Type TYPE>
+    class Static_Reader
+    {
+    private:
+        // Set when the reader loaded the file, empty when parsing caller owned memory
+        std::shared_ptr<const void> m_storage;
+        const char *m_iter = nullptr;
+        const char *m_end = nullptr;
+
+        void init(const char *data, size_t size)
+        {
+            m_iter = data;
+            m_end = data + size;
+            if (TYPE == File_Writer::Type::BINARY)
+            {
+                uint32_t header_count;
+                memcpy(&header_count, data + Binary_Record::HEADER_SIZE, sizeof(uint32_t));
+                uint64_t num_triangles = Binary_Record::triangle_count(header_count, size);
+                m_iter = data + Binary_Record::TRIANGLES_OFFSET;
+                m_end = m_iter + num_triangles * Binary_Record::SIZE;
+            }
+        }
+
+    public:
+        // Memory maps the file where supported
+        explicit Static_Reader(const char *filepath)
+        {
+            File_Contents contents = load_file(filepath, TYPE);
+            m_storage = std::move(contents.storage);
+            init(contents.data, contents.size);
+        }
+
+        // Parses STL data in memory without copying it, data must outlive the reader,
+        // throws if data is not an STL file of the reader's type
+        Static_Reader(const void *data, size_t size)
+        {
+            if (read_header(data, size).type != TYPE)
+            {
+                throw std::runtime_error("Data does not match the reader's format");
+            }
+            init(static_cast<const char *>(data), size);
+        }
+
+        bool read_next_triangle(Triangle *res)
+        {
+            if (TYPE == File_Writer::Type::BINARY)
+            {
+                if (m_iter == m_end)
+                {
+                    return false;
+                }
+                Binary_Record::decode(reinterpret_cast<const unsigned char *>(m_iter), res);
+                m_iter += Binary_Record::SIZE;
+                return true;
+            }
+            return ASCII_Facet::parse(m_iter, m_end, res);
+        }
+
+        // Calls callback(const Triangle &) for each remaining triangle, returns number of triangles visited
+        template <typename Callback>
+        size_t for_each_triangle(Callback &&callback)
+        {
+            size_t count = 0;
+            Triangle t;
+            while (read_next_triangle(&t))
+            {
+                callback(static_cast<const Triangle &>(t));
+                count++;
+            }
+            return count;
+        }
+    };
+
+    // Writing shares the library writers (header, solid name, count patching, preallocation and output),
+    // only the per triangle call is avoided: triangles are collected here and handed over in batches
+    template <File_Writer::Type TYPE>
+    class Static_Writer
+    {
+    private:
+        static constexpr size_t BATCH_SIZE = 4096;
+        std::unique_ptr<File_Writer> m_writer;
+        std::unique_ptr<Triangle[]> m_triangles{new Triangle[BATCH_SIZE]};
+        std::unique_ptr<uint16_t[]> m_attributes{new uint16_t[BATCH_SIZE]};
+        size_t m_count = 0;
+
+        void flush()
+        {
+            m_writer->write_triangles_with_attributes(m_triangles.get(), m_attributes.get(), m_count);
+            m_count = 0;
+        }
+
+    public:
+        explicit Static_Writer(const char *filepath, const Writer_Options &options = Writer_Options())
+            : m_writer(create_writer(filepath, TYPE, options))
+        {
+        }
+
+        // Appends to buffer, which is complete only after the writer is closed or destroyed
+        explicit Static_Writer(std::vector<char> *buffer, const Writer_Options &options = Writer_Options())
+            : m_writer(create_writer(buffer, TYPE, options))
+        {
+        }
+
+        Static_Writer(const Static_Writer &) = delete;
+        Static_Writer &operator=(const Static_Writer &) = delete;
+
+        // Writing errors of the destructor are lost, call close to have them thrown
+        ~Static_Writer()
+        {
+            try
+            {
+                close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        // Writes the remaining triangles and completes the file, the writer cannot be used afterwards
+        void close()
+        {
+            if (m_writer == nullptr)
+            {
+                return;
+            }
+            std::unique_ptr<File_Writer> writer = std::move(m_writer);
+            writer->write_triangles_with_attributes(m_triangles.get(), m_attributes.get(), m_count);
+            m_count = 0;
+        }
+
+        // attribute_byte_count is ignored by ASCII files
+        void write_triangle(const Triangle &t, uint16_t attribute_byte_count = 0)
+        {
+            m_triangles[m_count] = t;
+            m_attributes[m_count] = attribute_byte_count;
+            if (++m_count == BATCH_SIZE)
+            {
+                flush();
+            }
+        }
+    };
+
+    using Static_Binary_Reader = Static_Reader<File_Writer::Type::BINARY>;
+    using Static_ASCII_Reader = Static_Reader<File_Writer::Type::ASCII>;
+    using Static_Binary_Writer = Static_Writer<File_Writer::Type::BINARY>;
+    using Static_ASCII_Writer = Static_Writer<File_Writer::Type::ASCII>;
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#if TINY_STL_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#if TINY_STL_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "non_copyable.hpp"
+
+// Sequential source of bytes for the streaming readers,
+// either a file (which can be a pipe) or a decompressor wrapping another stream
+class Input_Stream : public NonCopyable
+{
+public:
+    virtual ~Input_Stream() = default;
+    // Returns number of bytes read, which is less than size only at the end of the stream
+    virtual size_t read(void *data, size_t size) = 0;
+};
+
+class File_Input_Stream final : public Input_Stream
+{
+private:
+    FILE *m_file = nullptr;
+    // Bytes that were already consumed from file (e.g. while detecting its format),
+    // they are returned before the rest of the file
+    std::vector<unsigned char> m_prefix;
+    size_t m_prefix_pos = 0;
+
+public:
+    explicit File_Input_Stream(FILE *file, const void *prefix = nullptr, size_t prefix_size = 0);
+    ~File_Input_Stream() override;
+    size_t read(void *data, size_t size) override;
+};
+
+File_Input_Stream::File_Input_Stream(FILE *file, const void *prefix, size_t prefix_size) : m_file(file)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(prefix);
+    m_prefix.assign(bytes, bytes + prefix_size);
+}
+
+File_Input_Stream::~File_Input_Stream()
+{
+    fclose(m_file);
+}
+
+size_t File_Input_Stream::read(void *data, size_t size)
+{
+    unsigned char *out = static_cast<unsigned char *>(data);
+    size_t from_prefix = m_prefix.size() - m_prefix_pos;
+    if (from_prefix > size)
+    {
+        from_prefix = size;
+    }
+    // data() may be nullptr when there is no prefix, which memcpy must not be given
+    if (from_prefix > 0)
+    {
+        memcpy(out, m_prefix.data() + m_prefix_pos, from_prefix);
+        m_prefix_pos += from_prefix;
+    }
+
+    size_t num_read = from_prefix;
+    while (num_read < size)
+    {
+        size_t n = fread(out + num_read, 1, size - num_read, m_file);
+        if (n == 0)
+        {
+            break;
+        }
+        num_read += n;
+    }
+    return num_read;
+}
+
+// Compressed inputs are recognized by their magic bytes
+enum class Compression
+{
+    NONE,
+    GZIP,
+    ZSTD
+};
+
+static inline Compression detect_compression(const unsigned char *sample, size_t sample_size)
+{
+    if (sample_size >= 2 && sample[0] == 0x1f && sample[1] == 0x8b)
+    {
+        return Compression::GZIP;
+    }
+    if (sample_size >= 4 && sample[0] == 0x28 && sample[1] == 0xb5 && sample[2] == 0x2f && sample[3] == 0xfd)
+    {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+// Compressed data is read from the source in blocks of this size
+static constexpr size_t COMPRESSED_BLOCK_SIZE = 256 * 1024;
+
+#if TINY_STL_HAS_ZLIB
+
+class Gzip_Input_Stream final : public Input_Stream
+{
+private:
+    std::unique_ptr<Input_Stream> m_source;
+    std::unique_ptr<unsigned char[]> m_block;
+    z_stream m_stream{};
+    bool m_source_eof = false;
+    bool m_finished = false;
+    // Set after a member was completely decoded, until the next one starts
+    bool m_between_members = false;
+
+public:
+    explicit Gzip_Input_Stream(std::unique_ptr<Input_Stream> source);
+    ~Gzip_Input_Stream() override;
+    size_t read(void *data, size_t size) override;
+};
+
+Gzip_Input_Stream::Gzip_Input_Stream(std::unique_ptr<Input_Stream> source)
+    : m_source(std::move(source)), m_block(new unsigned char[COMPRESSED_BLOCK_SIZE])
+{
+    // 15 + 16: gzip wrapper with the largest window
+    if (inflateInit2(&m_stream, 15 + 16) != Z_OK)
+    {
+        throw std::runtime_error("Failed to initialize zlib");
+    }
+}
+
+Gzip_Input_Stream::~Gzip_Input_Stream()
+{
+    inflateEnd(&m_stream);
+}
+
+size_t Gzip_Input_Stream::read(void *data, size_t size)
+{
+    m_stream.next_out = static_cast<Bytef *>(data);
+    m_stream.avail_out = (uInt)size;
+    while (m_stream.avail_out > 0 && !m_finished)
+    {
+        if (m_stream.avail_in == 0 && !m_source_eof)
+        {
+            size_t num_read = m_source->read(m_block.get(), COMPRESSED_BLOCK_SIZE);
+            m_source_eof = (num_read < COMPRESSED_BLOCK_SIZE);
+            m_stream.next_in = m_block.get();
+            m_stream.avail_in = (uInt)num_read;
+        }
+        if (m_between_members && m_stream.avail_in == 0 && m_source_eof)
+        {
+            m_finished = true;
+            break;
+        }
+
+        int result = inflate(&m_stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END)
+        {
+            // Concatenated gzip members decompress to the concatenation of their contents
+            if (inflateReset(&m_stream) != Z_OK)
+            {
+                throw std::runtime_error("Failed to decompress file");
+            }
+            m_between_members = true;
+        }
+        else if (result == Z_OK)
+        {
+            m_between_members = false;
+        }
+        else if (result == Z_BUF_ERROR && m_stream.avail_in == 0 && m_source_eof)
+        {
+            throw std::runtime_error("Compressed file is truncated");
+        }
+        else if (result != Z_OK && result != Z_BUF_ERROR)
+        {
+            throw std::runtime_error("Failed to decompress file");
+        }
+    }
+    return size - m_stream.avail_out;
+}
+
+#endif
+
+#if TINY_STL_HAS_ZSTD
+
+class Zstd_Input_Stream final : public Input_Stream
+{
+private:
+    std::unique_ptr<Input_Stream> m_source;
+    std::unique_ptr<unsigned char[]> m_block;
+    ZSTD_DStream *m_stream = nullptr;
+    ZSTD_inBuffer m_input{};
+    bool m_source_eof = false;
+    // Set while the current frame is not fully decoded
+    bool m_in_frame = false;
+
+public:
+    explicit Zstd_Input_Stream(std::unique_ptr<Input_Stream> source);
+    ~Zstd_Input_Stream() override;
+    size_t read(void *data, size_t size) override;
+};
+
+Zstd_Input_Stream::Zstd_Input_Stream(std::unique_ptr<Input_Stream> source)
+    : m_source(std::move(source)), m_block(new unsigned char[COMPRESSED_BLOCK_SIZE])
+{
+    m_stream = ZSTD_createDStream();
+    if (m_stream == nullptr || ZSTD_isError(ZSTD_initDStream(m_stream)))
+    {
+        ZSTD_freeDStream(m_stream);
+        throw std::runtime_error("Failed to initialize zstd");
+    }
+    m_input.src = m_block.get();
+}
+
+Zstd_Input_Stream::~Zstd_Input_Stream()
+{
+    ZSTD_freeDStream(m_stream);
+}
+
+size_t Zstd_Input_Stream::read(void *data, size_t size)
+{
+    ZSTD_outBuffer output{data, size, 0};
+    while (output.pos < output.size)
+    {
+        if (m_input.pos == m_input.size && !m_source_eof)
+        {
+            size_t num_read = m_source->read(m_block.get(), COMPRESSED_BLOCK_SIZE);
+            m_source_eof = (num_read < COMPRESSED_BLOCK_SIZE);
+            m_input.size = num_read;
+            m_input.pos = 0;
+        }
+
+        // Called even without input left, the decoder may still hold output to flush
+        bool has_input = m_input.pos < m_input.size;
+        size_t output_before = output.pos;
+        size_t result = ZSTD_decompressStream(m_stream, &output, &m_input);
+        if (ZSTD_isError(result))
+        {
+            throw std::runtime_error("Failed to decompress file");
+        }
+        if (!has_input && output.pos == output_before)
+        {
+            if (m_in_frame)
+            {
+                throw std::runtime_error("Compressed file is truncated");
+            }
+            break;
+        }
+        // 0 means a frame was completely decoded and flushed
+        m_in_frame = (result != 0);
+    }
+    return output.pos;
+}
+
+#endif
+
+// Wraps source in the decompressor for compression, throws if it is not available in this build
+static inline std::unique_ptr<Input_Stream> open_decompressor(Compression compression, std::unique_ptr<Input_Stream> source)
+{
+    switch (compression)
+    {
+    case Compression::GZIP:
+#if TINY_STL_HAS_ZLIB
+        return std::unique_ptr<Input_Stream>(new Gzip_Input_Stream(std::move(source)));
+#else
+        throw std::runtime_error("Reading gzip files requires building with zlib");
+#endif
+    case Compression::ZSTD:
+#if TINY_STL_HAS_ZSTD
+        return std::unique_ptr<Input_Stream>(new Zstd_Input_Stream(std::move(source)));
+#else
+        throw std::runtime_error("Reading zstd files requires building with zstd");
+#endif
+    default:
+        return source;
+    }
+}
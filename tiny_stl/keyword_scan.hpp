@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TINY_STL_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define TINY_STL_HAS_SSE2 0
+#endif
+
+// AVX2 code is compiled with a function level target attribute and only selected at runtime,
+// so the library itself does not need to be built with -mavx2
+#if TINY_STL_HAS_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define TINY_STL_HAS_AVX2 1
+#include <immintrin.h>
+#else
+#define TINY_STL_HAS_AVX2 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Finds first byte in [start, end) equal to either a or b, returns end if there is none.
+// Used to jump straight to candidate keyword starts ('v' for "vertex", 'n' for "normal", ...)
+// instead of comparing keywords at every byte
+using Find_Either_Fn = const char *(*)(const char *start, const char *end, char a, char b);
+
+static inline unsigned count_trailing_zeros(unsigned mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+static const char *find_either_scalar(const char *start, const char *end, char a, char b)
+{
+    while (start < end)
+    {
+        if (*start == a || *start == b)
+        {
+            return start;
+        }
+        start++;
+    }
+    return end;
+}
+
+#if TINY_STL_HAS_SSE2
+static const char *find_either_sse2(const char *start, const char *end, char a, char b)
+{
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while ((end - start) >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(start));
+        __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb));
+        unsigned mask = (unsigned)_mm_movemask_epi8(matches);
+        if (mask != 0)
+        {
+            return start + count_trailing_zeros(mask);
+        }
+        start += 16;
+    }
+    return find_either_scalar(start, end, a, b);
+}
+#endif
+
+#if TINY_STL_HAS_AVX2
+__attribute__((target("avx2"))) static const char *find_either_avx2(const char *start, const char *end, char a, char b)
+{
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    while ((end - start) >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(start));
+        __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(matches);
+        if (mask != 0)
+        {
+            return start + count_trailing_zeros(mask);
+        }
+        start += 32;
+    }
+    return find_either_sse2(start, end, a, b);
+}
+#endif
+
+static Find_Either_Fn select_find_either()
+{
+#if TINY_STL_HAS_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return find_either_avx2;
+    }
+#endif
+#if TINY_STL_HAS_SSE2
+    return find_either_sse2;
+#else
+    return find_either_scalar;
+#endif
+}
+
+static inline const char *find_either(const char *start, const char *end, char a, char b)
+{
+    static const Find_Either_Fn fn = select_find_either();
+    return fn(start, end, a, b);
+}
+
+// Counts "endfacet" keywords in [start, end), which is the number of facets of ASCII STL text,
+// candidates are positions holding both its first ('e') and last ('t') byte,
+// so only a few positions per facet need a full comparison
+using Count_Facets_Fn = size_t (*)(const char *start, const char *end);
+
+static constexpr size_t FACET_KEYWORD_SIZE = 8;
+
+static inline bool is_facet_keyword(const char *p)
+{
+    return memcmp(p, "endfacet", FACET_KEYWORD_SIZE) == 0;
+}
+
+static size_t count_facets_scalar(const char *start, const char *end)
+{
+    size_t count = 0;
+    while ((size_t)(end - start) >= FACET_KEYWORD_SIZE)
+    {
+        const char *candidate = static_cast<const char *>(memchr(start, 'e', (end - start) - FACET_KEYWORD_SIZE + 1));
+        if (candidate == nullptr)
+        {
+            break;
+        }
+        if (is_facet_keyword(candidate))
+        {
+            count++;
+            candidate += FACET_KEYWORD_SIZE - 1;
+        }
+        start = candidate + 1;
+    }
+    return count;
+}
+
+#if TINY_STL_HAS_SSE2
+static size_t count_facets_sse2(const char *start, const char *end)
+{
+    const __m128i first = _mm_set1_epi8('e');
+    const __m128i last = _mm_set1_epi8('t');
+    size_t count = 0;
+    // Keywords starting in a block may extend past it, the last byte load covers that
+    while ((size_t)(end - start) >= 16 + FACET_KEYWORD_SIZE - 1)
+    {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(start));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(start + FACET_KEYWORD_SIZE - 1));
+        __m128i matches = _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last));
+        unsigned mask = (unsigned)_mm_movemask_epi8(matches);
+        while (mask != 0)
+        {
+            count += is_facet_keyword(start + count_trailing_zeros(mask));
+            mask &= mask - 1;
+        }
+        start += 16;
+    }
+    return count + count_facets_scalar(start, end);
+}
+#endif
+
+#if TINY_STL_HAS_AVX2
+__attribute__((target("avx2"))) static size_t count_facets_avx2(const char *start, const char *end)
+{
+    const __m256i first = _mm256_set1_epi8('e');
+    const __m256i last = _mm256_set1_epi8('t');
+    size_t count = 0;
+    while ((size_t)(end - start) >= 32 + FACET_KEYWORD_SIZE - 1)
+    {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(start));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(start + FACET_KEYWORD_SIZE - 1));
+        __m256i matches = _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(matches);
+        while (mask != 0)
+        {
+            count += is_facet_keyword(start + count_trailing_zeros(mask));
+            mask &= mask - 1;
+        }
+        start += 32;
+    }
+    return count + count_facets_sse2(start, end);
+}
+#endif
+
+static Count_Facets_Fn select_count_facets()
+{
+#if TINY_STL_HAS_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return count_facets_avx2;
+    }
+#endif
+#if TINY_STL_HAS_SSE2
+    return count_facets_sse2;
+#else
+    return count_facets_scalar;
+#endif
+}
+
+static inline size_t count_facets(const char *start, const char *end)
+{
+    static const Count_Facets_Fn fn = select_count_facets();
+    return fn(start, end);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TINY_STL_HAS_MMAP 1
+#include <sys/mman.h>
+#else
+#define TINY_STL_HAS_MMAP 0
+#endif
+
+#include "non_copyable.hpp"
+
+#if TINY_STL_HAS_MMAP
+
+// How the mapping will be read, passed to the kernel to tune readahead
+enum class Map_Access
+{
+    // Front to back, pages are read ahead aggressively and can be dropped once passed
+    SEQUENTIAL,
+    // Arbitrary ranges, only the pages that are touched are read
+    RANDOM
+};
+
+// Read-only memory mapping of a whole file,
+// the mapping stays valid after the file itself is closed
+class Mapped_File : public NonCopyable
+{
+private:
+    void *m_data = nullptr;
+    size_t m_size = 0;
+
+public:
+    Mapped_File(FILE *file, size_t file_size, Map_Access access = Map_Access::SEQUENTIAL);
+    ~Mapped_File();
+    const unsigned char *data() const { return static_cast<const unsigned char *>(m_data); }
+    size_t size() const { return m_size; }
+};
+
+Mapped_File::Mapped_File(FILE *file, size_t file_size, Map_Access access)
+{
+    if (file_size == 0)
+    {
+        throw std::runtime_error("Cannot map empty file");
+    }
+
+    m_data = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (m_data == MAP_FAILED)
+    {
+        m_data = nullptr;
+        throw std::runtime_error("Failed to map file");
+    }
+    m_size = file_size;
+
+    // Only a hint, failure is harmless
+    madvise(m_data, m_size, (access == Map_Access::SEQUENTIAL) ? MADV_SEQUENTIAL : MADV_RANDOM);
+}
+
+Mapped_File::~Mapped_File()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+    }
+}
+
+#endif
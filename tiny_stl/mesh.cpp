@@ -0,0 +1,158 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "non_copyable.hpp"
+#include "tiny_stl.hpp"
+
+namespace Tiny_STL
+{
+    // Number of triangles decoded per read_triangles call
+    static constexpr size_t READ_BATCH_SIZE = 4096;
+
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    // Open addressing hash table (linear probing) from vertex coordinates bits to vertex index,
+    // keys are not stored, they are looked up in the vertices array instead
+    class Vertex_Welder : public NonCopyable
+    {
+    private:
+        std::vector<float> &m_vertices;
+        std::vector<uint32_t> m_slots;
+        size_t m_mask = 0;
+        size_t m_num_vertices = 0;
+
+        static size_t hash(const uint32_t bits[3])
+        {
+            uint64_t h = bits[0];
+            h = (h * 0x9E3779B97F4A7C15ull) ^ bits[1];
+            h = (h * 0x9E3779B97F4A7C15ull) ^ bits[2];
+            h *= 0x9E3779B97F4A7C15ull;
+            return (size_t)(h >> 32);
+        }
+
+        void grow()
+        {
+            std::vector<uint32_t> slots(m_slots.size() * 2, EMPTY_SLOT);
+            size_t mask = slots.size() - 1;
+            for (size_t i = 0; i < m_num_vertices; i++)
+            {
+                uint32_t bits[3];
+                memcpy(bits, &m_vertices[i * 3], sizeof(bits));
+                size_t slot = hash(bits) & mask;
+                while (slots[slot] != EMPTY_SLOT)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = (uint32_t)i;
+            }
+            m_slots.swap(slots);
+            m_mask = mask;
+        }
+
+    public:
+        explicit Vertex_Welder(std::vector<float> &vertices) : m_vertices(vertices), m_slots(1024, EMPTY_SLOT)
+        {
+            m_mask = m_slots.size() - 1;
+        }
+
+        uint32_t insert(const float vertex[3])
+        {
+            uint32_t bits[3];
+            memcpy(bits, vertex, sizeof(bits));
+
+            size_t slot = hash(bits) & m_mask;
+            while (m_slots[slot] != EMPTY_SLOT)
+            {
+                uint32_t index = m_slots[slot];
+                if (memcmp(&m_vertices[index * (size_t)3], bits, sizeof(bits)) == 0)
+                {
+                    return index;
+                }
+                slot = (slot + 1) & m_mask;
+            }
+
+            if (m_num_vertices >= EMPTY_SLOT)
+            {
+                throw std::runtime_error("Too many vertices");
+            }
+
+            uint32_t index = (uint32_t)m_num_vertices++;
+            m_slots[slot] = index;
+            m_vertices.insert(m_vertices.end(), vertex, vertex + 3);
+
+            // Keep load factor at or below 1/2
+            if (m_num_vertices * 2 > m_slots.size())
+            {
+                grow();
+            }
+            return index;
+        }
+    };
+
+    void read_indexed_mesh(File_Reader *reader, Indexed_Mesh *mesh)
+    {
+        mesh->vertices.clear();
+        mesh->indices.clear();
+        mesh->normals.clear();
+
+        Vertex_Welder welder(mesh->vertices);
+        std::vector<Triangle> batch(READ_BATCH_SIZE);
+        size_t count;
+        while ((count = reader->read_triangles(batch.data(), batch.size())) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const Triangle &t = batch[i];
+                mesh->normals.insert(mesh->normals.end(), t.normal, t.normal + 3);
+                for (int v = 0; v < 3; v++)
+                {
+                    mesh->indices.push_back(welder.insert(t.vertices[v]));
+                }
+            }
+        }
+    }
+
+    void read_soa_triangles(File_Reader *reader, SoA_Triangles *out, bool with_normals)
+    {
+        std::vector<float> *coords[3] = {&out->x, &out->y, &out->z};
+        std::vector<float> *normals[3] = {&out->normal_x, &out->normal_y, &out->normal_z};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            coords[axis]->clear();
+            normals[axis]->clear();
+        }
+
+        // Each batch is scattered into the output arrays while it is still in cache,
+        // so there is no separate transpose pass over the whole mesh
+        std::vector<Triangle> batch(READ_BATCH_SIZE);
+        size_t count;
+        while ((count = reader->read_triangles(batch.data(), batch.size())) > 0)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                std::vector<float> &dst = *coords[axis];
+                size_t offset = dst.size();
+                dst.resize(offset + count * 3);
+                for (size_t i = 0; i < count; i++)
+                {
+                    dst[offset + i * 3 + 0] = batch[i].vertices[0][axis];
+                    dst[offset + i * 3 + 1] = batch[i].vertices[1][axis];
+                    dst[offset + i * 3 + 2] = batch[i].vertices[2][axis];
+                }
+
+                if (with_normals)
+                {
+                    std::vector<float> &normal_dst = *normals[axis];
+                    offset = normal_dst.size();
+                    normal_dst.resize(offset + count);
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        normal_dst[offset + i] = batch[i].normal[axis];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TINY_STL_HAS_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TINY_STL_HAS_POSIX_IO 0
+#endif
+
+#include "non_copyable.hpp"
+
+// Destination of writers, either a file or a caller supplied growable memory buffer
+class Output : public NonCopyable
+{
+private:
+    FILE *m_file = nullptr;
+    std::vector<char> *m_memory = nullptr;
+    // Memory output appends to whatever the buffer already holds
+    size_t m_memory_start = 0;
+
+#if TINY_STL_HAS_POSIX_IO
+    // Preallocated file written with pwrite through a large aligned buffer instead of stdio
+    struct Free_Deleter
+    {
+        void operator()(char *p) const { free(p); }
+    };
+    static constexpr size_t DIRECT_BUFFER_SIZE = 8 * 1024 * 1024;
+    int m_fd = -1;
+    std::unique_ptr<char, Free_Deleter> m_direct_buffer;
+    size_t m_direct_buffered = 0;
+    // Offset in the file of the first buffered byte
+    uint64_t m_direct_offset = 0;
+    bool m_direct_failed = false;
+
+    bool flush_direct();
+#endif
+
+public:
+    explicit Output(const char *filepath);
+    // Preallocates expected_size bytes for the file where supported,
+    // the file is truncated to the bytes actually written when the output is destroyed
+    Output(const char *filepath, uint64_t expected_size);
+    explicit Output(std::vector<char> *memory);
+    ~Output();
+    // Returns number of bytes written, 0 once a write to a preallocated file has failed
+    size_t write(const void *data, size_t size);
+    // Hands buffered bytes to the file, returns the number of bytes stored so far,
+    // which is less than what write accepted when buffered bytes failed to reach the file
+    uint64_t flush();
+    // Overwrites already written bytes, offset is relative to the start of the output
+    bool overwrite(size_t offset, const void *data, size_t size);
+};
+
+Output::Output(const char *filepath)
+{
+    m_file = fopen(filepath, "wb");
+    if (m_file == nullptr)
+    {
+        throw std::runtime_error("Failed to open file");
+    }
+}
+
+Output::Output(const char *filepath, uint64_t expected_size)
+{
+#if TINY_STL_HAS_POSIX_IO
+    m_fd = open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (m_fd == -1)
+    {
+        throw std::runtime_error("Failed to open file");
+    }
+
+#if defined(__linux__)
+    // Reserving all blocks up front avoids growing the file on every write,
+    // failure (e.g. unsupported by the file system) only loses the optimization
+    posix_fallocate(m_fd, 0, (off_t)expected_size);
+#else
+    (void)expected_size;
+#endif
+
+    void *buffer = nullptr;
+    if (posix_memalign(&buffer, 4096, DIRECT_BUFFER_SIZE) != 0)
+    {
+        close(m_fd);
+        throw std::runtime_error("Failed to allocate output buffer");
+    }
+    m_direct_buffer.reset(static_cast<char *>(buffer));
+#else
+    (void)expected_size;
+    m_file = fopen(filepath, "wb");
+    if (m_file == nullptr)
+    {
+        throw std::runtime_error("Failed to open file");
+    }
+#endif
+}
+
+Output::Output(std::vector<char> *memory)
+{
+    m_memory = memory;
+    m_memory_start = memory->size();
+}
+
+Output::~Output()
+{
+    if (m_file)
+    {
+        fclose(m_file);
+    }
+
+#if TINY_STL_HAS_POSIX_IO
+    if (m_fd != -1)
+    {
+        flush_direct();
+        // Drop preallocated space that was not written
+        if (ftruncate(m_fd, (off_t)m_direct_offset) != 0)
+        {
+            m_direct_failed = true;
+        }
+        close(m_fd);
+    }
+#endif
+}
+
+#if TINY_STL_HAS_POSIX_IO
+bool Output::flush_direct()
+{
+    size_t written = 0;
+    while (written < m_direct_buffered && !m_direct_failed)
+    {
+        ssize_t n = pwrite(m_fd, m_direct_buffer.get() + written, m_direct_buffered - written, (off_t)(m_direct_offset + written));
+        if (n <= 0)
+        {
+            m_direct_failed = true;
+            break;
+        }
+        written += (size_t)n;
+    }
+    m_direct_offset += written;
+    m_direct_buffered = 0;
+    return !m_direct_failed;
+}
+#endif
+
+size_t Output::write(const void *data, size_t size)
+{
+    if (m_file)
+    {
+        return fwrite(data, 1, size, m_file);
+    }
+
+#if TINY_STL_HAS_POSIX_IO
+    if (m_fd != -1)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        size_t written = 0;
+        while (written < size && !m_direct_failed)
+        {
+            if (m_direct_buffered == DIRECT_BUFFER_SIZE && !flush_direct())
+            {
+                break;
+            }
+            size_t n = size - written;
+            if (n > DIRECT_BUFFER_SIZE - m_direct_buffered)
+            {
+                n = DIRECT_BUFFER_SIZE - m_direct_buffered;
+            }
+            memcpy(m_direct_buffer.get() + m_direct_buffered, bytes + written, n);
+            m_direct_buffered += n;
+            written += n;
+        }
+        return written;
+    }
+#endif
+
+    const char *bytes = static_cast<const char *>(data);
+    m_memory->insert(m_memory->end(), bytes, bytes + size);
+    return size;
+}
+
+uint64_t Output::flush()
+{
+    if (m_file)
+    {
+        fflush(m_file);
+        long position = ftell(m_file);
+        return (position != -1L) ? (uint64_t)position : 0;
+    }
+
+#if TINY_STL_HAS_POSIX_IO
+    if (m_fd != -1)
+    {
+        flush_direct();
+        return m_direct_offset;
+    }
+#endif
+
+    return m_memory->size() - m_memory_start;
+}
+
+bool Output::overwrite(size_t offset, const void *data, size_t size)
+{
+    if (m_file)
+    {
+        long position = ftell(m_file);
+        bool success = (position != -1L) && (fseek(m_file, (long)offset, SEEK_SET) == 0);
+        success = success && (fwrite(data, size, 1, m_file) == 1);
+        success = success && (fseek(m_file, position, SEEK_SET) == 0);
+        return success;
+    }
+
+#if TINY_STL_HAS_POSIX_IO
+    if (m_fd != -1)
+    {
+        if (offset + size > m_direct_offset + m_direct_buffered)
+        {
+            return false;
+        }
+        // Bytes may be partly flushed and partly still buffered
+        const char *bytes = static_cast<const char *>(data);
+        if (offset < m_direct_offset)
+        {
+            size_t flushed = (m_direct_offset - offset < size) ? (size_t)(m_direct_offset - offset) : size;
+            if (pwrite(m_fd, bytes, flushed, (off_t)offset) != (ssize_t)flushed)
+            {
+                return false;
+            }
+            bytes += flushed;
+            offset += flushed;
+            size -= flushed;
+        }
+        memcpy(m_direct_buffer.get() + (offset - m_direct_offset), bytes, size);
+        return true;
+    }
+#endif
+
+    if (m_memory_start + offset + size > m_memory->size())
+    {
+        return false;
+    }
+    memcpy(m_memory->data() + m_memory_start + offset, data, size);
+    return true;
+}
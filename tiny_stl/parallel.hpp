@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use for a requested count, 0 means all hardware threads
+static inline unsigned resolve_num_threads(unsigned requested)
+{
+    if (requested != 0)
+    {
+        return requested;
+    }
+    unsigned hardware_threads = std::thread::hardware_concurrency();
+    return (hardware_threads == 0) ? 1 : hardware_threads;
+}
+
+// Calls fn(task_index) for every task index in [0, num_tasks) using up to num_threads threads,
+// the calling thread takes part in the work, first exception thrown by a task is rethrown
+template <typename Fn>
+static void parallel_for(size_t num_tasks, unsigned num_threads, Fn fn)
+{
+    if (num_threads <= 1 || num_tasks <= 1)
+    {
+        for (size_t i = 0; i < num_tasks; i++)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_task{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]()
+    {
+        size_t task;
+        while ((task = next_task.fetch_add(1)) < num_tasks)
+        {
+            try
+            {
+                fn(task);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    size_t num_workers = (num_tasks < num_threads) ? num_tasks : num_threads;
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers - 1);
+    for (size_t i = 1; i < num_workers; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
@@ -1,15 +1,204 @@
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 
+#include "format_detection.hpp"
+#include "input_stream.hpp"
+#include "mapped_file.hpp"
 #include "reader_ascii.hpp"
+#include "reader_ascii_stream.hpp"
 #include "reader_binary.hpp"
+#include "reader_binary_memory.hpp"
+#include "reader_binary_stream.hpp"
+#include "reader_binary_uring.hpp"
 #include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
 
 namespace Tiny_STL
 {
-    std::unique_ptr<File_Reader> create_reader(const char *filepath)
+    // Window used for files that cannot be read whole because their size is unknown
+    static constexpr size_t DEFAULT_STREAM_WINDOW_SIZE = 1024 * 1024;
+
+    struct File_Layout
+    {
+        unsigned char sample[Format_Detection::SAMPLE_SIZE];
+        size_t sample_size = 0;
+        // -1 when the size is unknown (pipe, stdin, ...)
+        int64_t file_size = -1;
+        bool is_binary = false;
+        // Only set for binary files
+        uint64_t num_tris = 0;
+        // Format is only detected once compressed files are decompressed
+        Compression compression = Compression::NONE;
+
+        void detect()
+        {
+            is_binary = Format_Detection::is_binary(sample, sample_size, file_size);
+            if (is_binary)
+            {
+                num_tris = Format_Detection::binary_triangle_count(sample, file_size);
+            }
+        }
+    };
+
+    static File_Layout read_file_layout(FILE *file)
+    {
+        File_Layout layout;
+
+        // Leading bytes are read rather than seeked to, so that pipes can be detected too
+        layout.sample_size = fread(layout.sample, 1, sizeof(layout.sample), file);
+        if (layout.sample_size == 0)
+        {
+            fclose(file);
+            throw std::runtime_error("Failed to read from file");
+        }
+
+        layout.compression = detect_compression(layout.sample, layout.sample_size);
+        if (layout.compression != Compression::NONE)
+        {
+            return layout;
+        }
+
+        if (fseek(file, 0, SEEK_END) == 0)
+        {
+            layout.file_size = ftell(file);
+        }
+
+        layout.detect();
+        return layout;
+    }
+
+    static File_Layout read_stream_layout(Input_Stream *input)
+    {
+        File_Layout layout;
+        layout.sample_size = input->read(layout.sample, sizeof(layout.sample));
+        if (layout.sample_size == 0)
+        {
+            throw std::runtime_error("Failed to read from file");
+        }
+        layout.detect();
+        return layout;
+    }
+
+    static File_Layout memory_layout(const void *data, size_t size)
+    {
+        File_Layout layout;
+        if (size == 0)
+        {
+            throw std::runtime_error("Data too short");
+        }
+        layout.sample_size = (size < sizeof(layout.sample)) ? size : sizeof(layout.sample);
+        memcpy(layout.sample, data, layout.sample_size);
+        layout.file_size = (int64_t)size;
+        layout.detect();
+        return layout;
+    }
+
+    static std::unique_ptr<Random_Access_Reader> create_binary_reader(FILE *file, const File_Layout &layout, const Reader_Options &options,
+                                                                      bool random_access = false)
+    {
+        assert(layout.file_size >= 0);
+#if TINY_STL_HAS_MMAP
+        if (options.use_mmap)
+        {
+            Map_Access access = random_access ? Map_Access::RANDOM : Map_Access::SEQUENTIAL;
+            return std::make_unique<Binary_Mmap_File_Reader>(file, layout.file_size, layout.num_tris, options.num_threads, access);
+        }
+#endif
+        (void)random_access;
+        return std::make_unique<Binary_File_Reader>(file, layout.num_tris);
+    }
+
+    // Reads input sequentially, bytes consumed by detection are handed over to the reader
+    static std::unique_ptr<File_Reader> create_stream_reader(std::unique_ptr<Input_Stream> input, const File_Layout &layout, const Reader_Options &options)
+    {
+        if (layout.is_binary)
+        {
+            const unsigned char *records = layout.sample + Binary_Record::TRIANGLES_OFFSET;
+            return std::make_unique<Binary_Stream_Reader>(std::move(input), layout.num_tris, records, layout.sample_size - Binary_Record::TRIANGLES_OFFSET);
+        }
+        size_t window_size = options.stream_window_size ? options.stream_window_size : DEFAULT_STREAM_WINDOW_SIZE;
+        return std::make_unique<ASCII_Stream_Reader>(std::move(input), window_size, reinterpret_cast<const char *>(layout.sample), layout.sample_size);
+    }
+
+    static Header header_from_layout(const File_Layout &layout)
+    {
+        Header header;
+        if (layout.is_binary)
+        {
+            header.type = File_Writer::Type::BINARY;
+            memcpy(header.binary, layout.sample, Binary_Record::HEADER_SIZE);
+            header.solid_name = Format_Detection::solid_name(layout.sample, Binary_Record::HEADER_SIZE);
+        }
+        else
+        {
+            header.type = File_Writer::Type::ASCII;
+            header.solid_name = Format_Detection::solid_name(layout.sample, layout.sample_size);
+        }
+        return header;
+    }
+
+    // header, when not nullptr, is filled from the same bytes the format is detected from
+    static std::unique_ptr<File_Reader> create_file_reader(FILE *file, const Reader_Options &options, Header *header)
+    {
+        File_Layout layout = read_file_layout(file);
+
+        if (layout.compression != Compression::NONE)
+        {
+            // Decompressed on the fly, the format is detected from the decompressed bytes
+            std::unique_ptr<Input_Stream> input = open_decompressor(layout.compression,
+                                                                    std::make_unique<File_Input_Stream>(file, layout.sample, layout.sample_size));
+            File_Layout decompressed_layout = read_stream_layout(input.get());
+            if (header != nullptr)
+            {
+                *header = header_from_layout(decompressed_layout);
+            }
+            return create_stream_reader(std::move(input), decompressed_layout, options);
+        }
+
+        if (header != nullptr)
+        {
+            *header = header_from_layout(layout);
+        }
+
+        if (layout.file_size == -1)
+        {
+            // File is not seekable (pipe, stdin, ...)
+            return create_stream_reader(std::make_unique<File_Input_Stream>(file), layout, options);
+        }
+
+        if (layout.is_binary)
+        {
+#if TINY_STL_HAS_IO_URING
+            if (options.use_io_uring)
+            {
+                return std::make_unique<Binary_Uring_File_Reader>(file, layout.num_tris);
+            }
+#endif
+            return create_binary_reader(file, layout, options);
+        }
+        else if (options.stream_window_size != 0)
+        {
+            if (fseek(file, 0, SEEK_SET) != 0)
+            {
+                throw std::runtime_error("Failed to seek file");
+            }
+            return std::make_unique<ASCII_Stream_Reader>(std::make_unique<File_Input_Stream>(file), options.stream_window_size);
+        }
+        else
+        {
+            return std::make_unique<ASCII_File_Reader>(file, layout.file_size, options.num_threads);
+        }
+    }
+
+    std::unique_ptr<File_Reader> create_reader(const char *filepath, const Reader_Options &options)
+    {
+        return create_reader(filepath, options, nullptr);
+    }
+
+    std::unique_ptr<File_Reader> create_reader(const char *filepath, const Reader_Options &options, Header *header)
     {
         FILE *file = fopen(filepath, "rb");
 
@@ -18,37 +207,275 @@ namespace Tiny_STL
             throw std::runtime_error("Failed to open file");
         }
 
-        if (fseek(file, 80, SEEK_SET) != 0)
+        return create_file_reader(file, options, header);
+    }
+
+    std::unique_ptr<File_Reader> create_reader(FILE *file, const Reader_Options &options)
+    {
+        return create_file_reader(file, options, nullptr);
+    }
+
+    std::unique_ptr<Random_Access_Reader> create_random_access_reader(const char *filepath, const Reader_Options &options)
+    {
+        FILE *file = fopen(filepath, "rb");
+
+        if (!file)
         {
-            throw std::runtime_error("Failed to seek file");
+            throw std::runtime_error("Failed to open file");
         }
 
-        uint32_t num_tris = 0;
-        if (fread(&num_tris, sizeof(uint32_t), 1, file) != 1)
+        File_Layout layout = read_file_layout(file);
+        if (layout.compression != Compression::NONE)
         {
-            throw std::runtime_error("Failed to read from file");
+            fclose(file);
+            throw std::runtime_error("Random access is not supported for compressed files");
+        }
+        if (!layout.is_binary)
+        {
+            fclose(file);
+            throw std::runtime_error("Random access is only supported for binary files");
+        }
+
+        return create_binary_reader(file, layout, options, true);
+    }
+
+    std::unique_ptr<File_Reader> create_reader(const void *data, size_t size, const Reader_Options &options)
+    {
+        File_Layout layout = memory_layout(data, size);
+        if (layout.is_binary)
+        {
+            size_t binary_size = Binary_Record::TRIANGLES_OFFSET + layout.num_tris * Binary_Record::SIZE;
+            return std::make_unique<Binary_Memory_Reader>(static_cast<const unsigned char *>(data), binary_size, options.num_threads);
         }
+        return std::make_unique<ASCII_File_Reader>(static_cast<const char *>(data), size, options.num_threads);
+    }
+
+    Header read_header(const char *filepath)
+    {
+        FILE *file = fopen(filepath, "rb");
 
-        if (fseek(file, 0, SEEK_END) != 0)
+        if (!file)
         {
-            throw std::runtime_error("Failed to seek file");
+            throw std::runtime_error("Failed to open file");
         }
 
-        long file_size = ftell(file);
+        File_Layout layout = read_file_layout(file);
+        if (layout.compression != Compression::NONE)
+        {
+            std::unique_ptr<Input_Stream> input = open_decompressor(layout.compression,
+                                                                    std::make_unique<File_Input_Stream>(file, layout.sample, layout.sample_size));
+            return header_from_layout(read_stream_layout(input.get()));
+        }
+        fclose(file);
+        return header_from_layout(layout);
+    }
 
-        if (file_size == -1L)
+    Header read_header(const void *data, size_t size)
+    {
+        return header_from_layout(memory_layout(data, size));
+    }
+
+    // Estimates the number of facets of an ASCII file of file_size bytes from its leading bytes
+    static void estimate_ascii_triangle_count(const char *text, size_t text_size, int64_t file_size, Probe_Result *result)
+    {
+        uint64_t num_facets = 0;
+        const char *last_facet_end = text;
+        const char *facet_end;
+        while ((facet_end = find_facet_boundary(last_facet_end, text + text_size)) != nullptr)
         {
-            throw std::runtime_error("Failed to get file size");
+            last_facet_end = facet_end;
+            num_facets++;
         }
 
-        assert(file_size >= 0);
-        if ((size_t)file_size == (84 + num_tris * 50))
+        if (file_size >= 0 && (uint64_t)file_size == text_size)
         {
-            return std::make_unique<Binary_File_Reader>(file);
+            result->triangle_count = num_facets;
+            result->triangle_count_is_exact = true;
+        }
+        else if (num_facets > 0 && file_size >= 0)
+        {
+            double bytes_per_facet = (double)(last_facet_end - text) / num_facets;
+            result->triangle_count = (uint64_t)((double)file_size / bytes_per_facet + 0.5);
+        }
+    }
+
+    Probe_Result probe(const char *filepath)
+    {
+        FILE *file = fopen(filepath, "rb");
+
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open file");
+        }
+
+        Probe_Result result;
+        File_Layout layout = read_file_layout(file);
+        if (layout.compression != Compression::NONE)
+        {
+            // Only the header of the decompressed data is looked at, its size is unknown
+            result.compressed = true;
+            std::unique_ptr<Input_Stream> input = open_decompressor(layout.compression,
+                                                                    std::make_unique<File_Input_Stream>(file, layout.sample, layout.sample_size));
+            File_Layout decompressed_layout = read_stream_layout(input.get());
+            result.header = header_from_layout(decompressed_layout);
+            result.triangle_count = decompressed_layout.num_tris;
+            return result;
+        }
+
+        result.header = header_from_layout(layout);
+        result.file_size = layout.file_size;
+        if (layout.is_binary)
+        {
+            fclose(file);
+            result.triangle_count = layout.num_tris;
+            // Without a size the header count cannot be checked against the data
+            result.triangle_count_is_exact = (layout.file_size >= 0);
+            return result;
+        }
+
+        constexpr size_t PROBE_SIZE = 64 * 1024;
+        std::unique_ptr<char[]> text(new char[PROBE_SIZE]);
+        size_t text_size = 0;
+        if (layout.file_size >= 0 && fseek(file, 0, SEEK_SET) == 0)
+        {
+            text_size = fread(text.get(), 1, PROBE_SIZE, file);
         }
         else
         {
-            return std::make_unique<ASCII_File_Reader>(file, file_size);
+            // Pipe, the sample is all that can be looked at without consuming it
+            text_size = layout.sample_size;
+            memcpy(text.get(), layout.sample, text_size);
         }
+        fclose(file);
+
+        estimate_ascii_triangle_count(text.get(), text_size, layout.file_size, &result);
+        return result;
+    }
+
+    // Counts facets of ASCII text read from input in large blocks,
+    // prefix holds bytes that were already consumed from input
+    static uint64_t count_stream_facets(Input_Stream *input, const unsigned char *prefix, size_t prefix_size)
+    {
+        // A keyword that starts in the last bytes of a block is completed by the next one,
+        // so those bytes are carried over, they are too few to hold a whole keyword and be counted twice
+        constexpr size_t COUNT_BLOCK_SIZE = 1024 * 1024;
+        constexpr size_t CARRY_SIZE = FACET_KEYWORD_SIZE - 1;
+        size_t head_size = (prefix_size > CARRY_SIZE) ? prefix_size : CARRY_SIZE;
+        std::unique_ptr<char[]> block(new char[head_size + COUNT_BLOCK_SIZE]);
+        memcpy(block.get(), prefix, prefix_size);
+        size_t carried = prefix_size;
+        uint64_t count = 0;
+        while (true)
+        {
+            size_t num_read = input->read(block.get() + carried, COUNT_BLOCK_SIZE);
+            size_t filled = carried + num_read;
+            if (num_read < COUNT_BLOCK_SIZE)
+            {
+                return count + count_facets(block.get(), block.get() + filled);
+            }
+            count += count_facets(block.get(), block.get() + filled);
+            memmove(block.get(), block.get() + filled - CARRY_SIZE, CARRY_SIZE);
+            carried = CARRY_SIZE;
+        }
+    }
+
+    uint64_t count_triangles(const char *filepath)
+    {
+        FILE *file = fopen(filepath, "rb");
+
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open file");
+        }
+
+        File_Layout layout = read_file_layout(file);
+        std::unique_ptr<Input_Stream> input;
+        if (layout.compression != Compression::NONE)
+        {
+            input = open_decompressor(layout.compression, std::make_unique<File_Input_Stream>(file, layout.sample, layout.sample_size));
+            layout = read_stream_layout(input.get());
+        }
+        else
+        {
+            input = std::make_unique<File_Input_Stream>(file);
+            // Detection seeks to the end of seekable files, continue right after the sample
+            if (layout.file_size >= 0 && fseek(file, (long)layout.sample_size, SEEK_SET) != 0)
+            {
+                throw std::runtime_error("Failed to seek file");
+            }
+        }
+
+        if (layout.is_binary)
+        {
+            return layout.num_tris;
+        }
+        return count_stream_facets(input.get(), layout.sample, layout.sample_size);
+    }
+
+    uint64_t count_triangles(const void *data, size_t size)
+    {
+        File_Layout layout = memory_layout(data, size);
+        if (layout.is_binary)
+        {
+            return layout.num_tris;
+        }
+        const char *text = static_cast<const char *>(data);
+        return count_facets(text, text + size);
+    }
+
+    File_Contents load_file(const char *filepath, File_Writer::Type type)
+    {
+        FILE *file = fopen(filepath, "rb");
+
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open file");
+        }
+
+        File_Layout layout = read_file_layout(file);
+        if (layout.compression != Compression::NONE || layout.file_size <= 0)
+        {
+            fclose(file);
+            throw std::runtime_error("Static readers only read uncompressed regular files");
+        }
+        if ((type == File_Writer::Type::BINARY) != layout.is_binary)
+        {
+            fclose(file);
+            throw std::runtime_error("File does not match the reader's format");
+        }
+
+        File_Contents contents;
+        contents.size = (size_t)layout.file_size;
+#if TINY_STL_HAS_MMAP
+        std::shared_ptr<Mapped_File> mapping;
+        try
+        {
+            mapping = std::make_shared<Mapped_File>(file, contents.size);
+        }
+        catch (...)
+        {
+            fclose(file);
+            throw;
+        }
+        fclose(file);
+        contents.data = reinterpret_cast<const char *>(mapping->data());
+        contents.storage = std::move(mapping);
+#else
+        std::shared_ptr<char> storage(new char[contents.size], std::default_delete<char[]>());
+        bool failed = (fseek(file, 0, SEEK_SET) != 0) || (fread(storage.get(), contents.size, 1, file) != 1);
+        fclose(file);
+        if (failed)
+        {
+            throw std::runtime_error("Failed to read from file");
+        }
+        contents.data = storage.get();
+        contents.storage = std::move(storage);
+#endif
+        return contents;
+    }
+
+    bool ASCII_Facet::parse(const char *&iter, const char *end, Triangle *res)
+    {
+        return parse_next_triangle(iter, end, res);
     }
 }
@@ -1,21 +1,41 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
 #include <fast_float.h>
 
+#include "keyword_scan.hpp"
 #include "non_copyable.hpp"
+#include "parallel.hpp"
 #include "tiny_stl.hpp"
 
-class ASCII_File_Reader : public Tiny_STL::File_Reader, public NonCopyable
+class ASCII_File_Reader final : public Tiny_STL::File_Reader, public NonCopyable
 {
 private:
-    char *m_buffer = nullptr;
-    char *m_iter = nullptr;
+    // Set when the text was read from a file, empty when parsing caller owned memory
+    std::unique_ptr<char[]> m_storage;
+    const char *m_buffer = nullptr;
+    const char *m_iter = nullptr;
     size_t m_buffer_size = 0;
 
+    // Filled when the whole file is parsed up front by multiple threads,
+    // triangles are then served from here in file order
+    bool m_parsed_in_parallel = false;
+    std::vector<Tiny_STL::Triangle> m_triangles;
+    size_t m_next_triangle = 0;
+
+    void parse_in_parallel(unsigned num_threads);
+
 public:
-    ASCII_File_Reader(FILE *file, size_t file_size);
-    ~ASCII_File_Reader() override;
+    ASCII_File_Reader(FILE *file, size_t file_size, unsigned num_threads = 1);
+    // Parses text in memory without copying it, data must outlive the reader
+    ASCII_File_Reader(const char *data, size_t size, unsigned num_threads = 1);
     bool read_next_triangle(Tiny_STL::Triangle *res) override;
+    size_t read_triangles(Tiny_STL::Triangle *out, size_t max_count) override;
+    size_t read_views(Tiny_STL::Triangle_View *out, size_t max_count) override;
 };
 
 static const char *skip_control_chars_or_plus(const char *start, const char *end)
@@ -44,7 +64,89 @@ static void read_float3(float out[3], const char *buf, const char *endptr)
     fast_float::from_chars(buf, endptr, out[2]);
 }
 
-ASCII_File_Reader::ASCII_File_Reader(FILE *file, size_t file_size)
+// Parses the next triangle in [iter, endptr), advancing iter past its last vertex
+static bool parse_next_triangle(const char *&iter, const char *endptr, Tiny_STL::Triangle *res)
+{
+    int vertex_counter = 0;
+    int normal_counter = 0;
+    while ((endptr - iter) > 6)
+    {
+        // Skip to the next byte that can start either keyword
+        iter = find_either(iter, endptr - 6, 'v', 'n');
+        if (iter == endptr - 6)
+        {
+            break;
+        }
+
+        if (memcmp(iter, "vertex", 6) == 0)
+        {
+            iter += 6;
+            read_float3(res->vertices[vertex_counter], iter, endptr);
+            vertex_counter++;
+        }
+        else if (memcmp(iter, "normal", 6) == 0)
+        {
+            iter += 6;
+            read_float3(res->normal, iter, endptr);
+            normal_counter++;
+        }
+        else
+        {
+            iter++;
+        }
+
+        if (vertex_counter >= 3)
+        {
+            // Normals should have been read before triangle vertices
+            // and only one normal should have been read
+            return (normal_counter == 1);
+        }
+    }
+
+    return false;
+}
+
+// Whether a "vertex" or "normal" keyword is left in [start, end), bounds match parse_next_triangle
+static bool contains_triangle_keyword(const char *start, const char *end)
+{
+    while ((end - start) > 6)
+    {
+        start = find_either(start, end - 6, 'v', 'n');
+        if (start == end - 6)
+        {
+            break;
+        }
+        if (memcmp(start, "vertex", 6) == 0 || memcmp(start, "normal", 6) == 0)
+        {
+            return true;
+        }
+        start++;
+    }
+    return false;
+}
+
+// Returns pointer just past the first "endfacet" at or after start, or nullptr if there is none
+static const char *find_facet_boundary(const char *start, const char *end)
+{
+    static const char keyword[] = "endfacet";
+    constexpr size_t keyword_size = sizeof(keyword) - 1;
+    while ((size_t)(end - start) >= keyword_size)
+    {
+        const char *candidate = static_cast<const char *>(memchr(start, 'e', (end - start) - keyword_size + 1));
+        if (candidate == nullptr)
+        {
+            break;
+        }
+        if (memcmp(candidate, keyword, keyword_size) == 0)
+        {
+            return candidate + keyword_size;
+        }
+        start = candidate + 1;
+    }
+    return nullptr;
+}
+
+ASCII_File_Reader::ASCII_File_Reader(FILE *file, size_t file_size, unsigned num_threads)
 {
     if (fseek(file, 0, SEEK_SET) != 0)
     {
@@ -57,51 +159,174 @@ ASCII_File_Reader::ASCII_File_Reader(FILE *file, size_t file_size)
     }
 
     m_buffer_size = file_size;
-    m_iter = m_buffer = new char[file_size];
-    if (fread(m_buffer, file_size, 1, file) != 1)
+    m_storage.reset(new char[file_size]);
+    m_buffer = m_storage.get();
+    m_iter = m_buffer;
+    if (fread(m_storage.get(), file_size, 1, file) != 1)
     {
         fclose(file);
         throw std::runtime_error("Failed to read from file");
     }
     fclose(file);
+
+    num_threads = resolve_num_threads(num_threads);
+    if (num_threads > 1)
+    {
+        parse_in_parallel(num_threads);
+    }
 }
 
-ASCII_File_Reader::~ASCII_File_Reader()
+ASCII_File_Reader::ASCII_File_Reader(const char *data, size_t size, unsigned num_threads)
 {
-    delete[] m_buffer;
+    if (size < 6)
+    {
+        throw std::runtime_error("File too short");
+    }
+
+    m_buffer_size = size;
+    m_buffer = data;
+    m_iter = m_buffer;
+
+    num_threads = resolve_num_threads(num_threads);
+    if (num_threads > 1)
+    {
+        parse_in_parallel(num_threads);
+    }
 }
 
-bool ASCII_File_Reader::read_next_triangle(Tiny_STL::Triangle *res)
+void ASCII_File_Reader::parse_in_parallel(unsigned num_threads)
 {
-    int vertex_counter = 0;
-    int normal_counter = 0;
-    const char *endptr = m_buffer + m_buffer_size;
-    while (m_iter < (endptr - 6))
+    // Small files are not worth the thread startup cost
+    constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+    const char *begin = m_buffer;
+    const char *end = m_buffer + m_buffer_size;
+
+    size_t num_chunks = m_buffer_size / MIN_CHUNK_SIZE;
+    if (num_chunks > num_threads)
+    {
+        num_chunks = num_threads;
+    }
+    if (num_chunks <= 1)
     {
-        if (memcmp(m_iter, "vertex", 6) == 0)
+        return;
+    }
+
+    // Chunks are split right after an "endfacet", so that every facet is parsed by exactly one worker
+    std::vector<const char *> boundaries(num_chunks + 1);
+    boundaries[0] = begin;
+    for (size_t i = 1; i < num_chunks; i++)
+    {
+        const char *nominal = begin + (m_buffer_size / num_chunks) * i;
+        if (nominal < boundaries[i - 1])
         {
-            m_iter += 6;
-            read_float3(res->vertices[vertex_counter], m_iter, endptr);
-            vertex_counter++;
+            nominal = boundaries[i - 1];
         }
-        else if (memcmp(m_iter, "normal", 6) == 0)
+        const char *boundary = find_facet_boundary(nominal, end);
+        boundaries[i] = boundary ? boundary : end;
+    }
+    boundaries[num_chunks] = end;
+
+    // A chunk fails when parsing stops before its end because of a malformed facet,
+    // or leaves keywords behind that serial parsing would combine with the next chunk
+    std::vector<std::vector<Tiny_STL::Triangle>> chunk_triangles(num_chunks);
+    std::vector<char> chunk_failed(num_chunks, 0);
+    parallel_for(num_chunks, num_threads, [&](size_t chunk)
+    {
+        const char *iter = boundaries[chunk];
+        const char *chunk_end = boundaries[chunk + 1];
+        std::vector<Tiny_STL::Triangle> &triangles = chunk_triangles[chunk];
+        Tiny_STL::Triangle t;
+        const char *parsed_end = iter;
+        while (parse_next_triangle(iter, chunk_end, &t))
         {
-            m_iter += 6;
-            read_float3(res->normal, m_iter, endptr);
-            normal_counter++;
+            triangles.push_back(t);
+            parsed_end = iter;
         }
-        else
+        chunk_failed[chunk] = contains_triangle_keyword(parsed_end, chunk_end);
+    });
+
+    // Chunks before the first failed one match serial parsing exactly, each of them ended cleanly,
+    // so the next one started where serial parsing continues, the rest is parsed serially from there,
+    // which keeps the result independent of the number of threads
+    size_t num_clean_chunks = 0;
+    size_t total = 0;
+    while (num_clean_chunks < num_chunks && !chunk_failed[num_clean_chunks])
+    {
+        total += chunk_triangles[num_clean_chunks++].size();
+    }
+    m_triangles.reserve(total);
+    for (size_t i = 0; i < num_clean_chunks; i++)
+    {
+        m_triangles.insert(m_triangles.end(), chunk_triangles[i].begin(), chunk_triangles[i].end());
+    }
+    if (num_clean_chunks < num_chunks)
+    {
+        const char *iter = boundaries[num_clean_chunks];
+        Tiny_STL::Triangle t;
+        while (parse_next_triangle(iter, end, &t))
         {
-            m_iter++;
+            m_triangles.push_back(t);
         }
+    }
+    m_parsed_in_parallel = true;
 
-        if (vertex_counter >= 3)
+    // Text is no longer needed once everything is parsed
+    m_storage.reset();
+    m_buffer = nullptr;
+    m_iter = nullptr;
+    m_buffer_size = 0;
+}
+
+bool ASCII_File_Reader::read_next_triangle(Tiny_STL::Triangle *res)
+{
+    if (m_parsed_in_parallel)
+    {
+        if (m_next_triangle >= m_triangles.size())
         {
-            // Normals should have been read before triangle vertices
-            // and only one normal should have been read
-            return (normal_counter == 1);
+            return false;
         }
+        *res = m_triangles[m_next_triangle++];
+        return true;
     }
 
-    return false;
+    return parse_next_triangle(m_iter, m_buffer + m_buffer_size, res);
+}
+
+size_t ASCII_File_Reader::read_triangles(Tiny_STL::Triangle *out, size_t max_count)
+{
+    if (m_parsed_in_parallel)
+    {
+        size_t available = m_triangles.size() - m_next_triangle;
+        size_t count = (max_count < available) ? max_count : available;
+        std::copy(m_triangles.begin() + m_next_triangle, m_triangles.begin() + m_next_triangle + count, out);
+        m_next_triangle += count;
+        return count;
+    }
+
+    // Class is final, so these calls are resolved statically and can be inlined
+    size_t count = 0;
+    while ((count < max_count) && read_next_triangle(out + count))
+    {
+        count++;
+    }
+    return count;
+}
+
+size_t ASCII_File_Reader::read_views(Tiny_STL::Triangle_View *out, size_t max_count)
+{
+    if (!m_parsed_in_parallel)
+    {
+        return File_Reader::read_views(out, max_count);
+    }
+
+    // Triangles parsed up front are already in memory, views point at them
+    size_t available = m_triangles.size() - m_next_triangle;
+    size_t count = (max_count < available) ? max_count : available;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = Tiny_STL::Triangle_View(&m_triangles[m_next_triangle + i]);
+    }
+    m_next_triangle += count;
+    return count;
 }
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "input_stream.hpp"
+#include "non_copyable.hpp"
+#include "reader_ascii.hpp"
+#include "tiny_stl.hpp"
+
+// Parses ASCII files through a fixed size window that is refilled from an input stream,
+// so memory use does not depend on file size, and works on pipes, stdin and compressed files,
+// returns the same triangles as ASCII_File_Reader, also for malformed facets
+class ASCII_Stream_Reader final : public Tiny_STL::File_Reader, public NonCopyable
+{
+private:
+    std::unique_ptr<Input_Stream> m_input;
+    std::unique_ptr<char[]> m_window;
+    size_t m_window_size = 0;
+    const char *m_iter = nullptr;
+    const char *m_end = nullptr;
+    bool m_eof = false;
+
+    static constexpr size_t MIN_WINDOW_SIZE = 4096;
+
+    void refill();
+
+public:
+    // prefix holds bytes that were already consumed from input (e.g. while detecting its format),
+    // they are parsed before the rest of the input
+    ASCII_Stream_Reader(std::unique_ptr<Input_Stream> input, size_t window_size, const char *prefix = nullptr, size_t prefix_size = 0);
+    bool read_next_triangle(Tiny_STL::Triangle *res) override;
+    size_t read_triangles(Tiny_STL::Triangle *out, size_t max_count) override;
+};
+
+ASCII_Stream_Reader::ASCII_Stream_Reader(std::unique_ptr<Input_Stream> input, size_t window_size, const char *prefix, size_t prefix_size)
+    : m_input(std::move(input))
+{
+    m_window_size = (window_size < MIN_WINDOW_SIZE) ? MIN_WINDOW_SIZE : window_size;
+    if (m_window_size < prefix_size)
+    {
+        m_window_size = prefix_size;
+    }
+
+    m_window.reset(new char[m_window_size]);
+    if (prefix_size > 0)
+    {
+        memcpy(m_window.get(), prefix, prefix_size);
+    }
+    m_iter = m_window.get();
+    m_end = m_window.get() + prefix_size;
+}
+
+void ASCII_Stream_Reader::refill()
+{
+    // Carry unparsed bytes (a partial facet) over to the start of the window
+    size_t remaining = m_end - m_iter;
+    if (remaining == m_window_size)
+    {
+        // A single facet does not fit, grow the window,
+        // this only happens for unusually long facets so memory use stays bounded
+        std::unique_ptr<char[]> window(new char[m_window_size * 2]);
+        memcpy(window.get(), m_iter, remaining);
+        m_window = std::move(window);
+        m_window_size *= 2;
+    }
+    else
+    {
+        memmove(m_window.get(), m_iter, remaining);
+    }
+    m_iter = m_window.get();
+    m_end = m_window.get() + remaining;
+
+    size_t num_read = m_input->read(m_window.get() + remaining, m_window_size - remaining);
+    m_end += num_read;
+    if (num_read < m_window_size - remaining)
+    {
+        m_eof = true;
+    }
+}
+
+// Whether the three numbers read after a "vertex" keyword ending at iter are whole in [iter, end),
+// a number is only known to be complete once a control character or space follows it
+static bool numbers_in_window(const char *iter, const char *end)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        iter = skip_control_chars_or_plus(iter, end);
+        while (iter < end && *iter > 32)
+        {
+            iter++;
+        }
+    }
+    return iter < end;
+}
+
+bool ASCII_Stream_Reader::read_next_triangle(Tiny_STL::Triangle *res)
+{
+    while (true)
+    {
+        // The window is parsed like the whole file would be, and the result is kept once more input cannot change it,
+        // parse_next_triangle only fails within 6 bytes of the end when it ran out of text,
+        // and reads the numbers of the last vertex after the position it stops at
+        const char *iter = m_iter;
+        bool success = parse_next_triangle(iter, m_end, res);
+        bool complete = success ? numbers_in_window(iter, m_end) : (m_end - iter) > 6;
+        if (complete || m_eof)
+        {
+            m_iter = iter;
+            return success;
+        }
+
+        refill();
+    }
+}
+
+size_t ASCII_Stream_Reader::read_triangles(Tiny_STL::Triangle *out, size_t max_count)
+{
+    size_t count = 0;
+    while ((count < max_count) && read_next_triangle(out + count))
+    {
+        count++;
+    }
+    return count;
+}
@@ -3,24 +3,41 @@
 #include <cstdio>
 #include <stdexcept>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define TINY_STL_HAS_PREAD 1
+#else
+#define TINY_STL_HAS_PREAD 0
+#endif
+
 #include "non_copyable.hpp"
 #include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
 
-class Binary_File_Reader : public Tiny_STL::File_Reader, public NonCopyable
+class Binary_File_Reader final : public Tiny_STL::Random_Access_Reader, public NonCopyable
 {
 private:
     FILE *m_file = nullptr;
+    size_t m_triangle_count = 0;
+    size_t m_triangles_left = 0;
 
 public:
-    explicit Binary_File_Reader(FILE *file);
+    // Non seekable files (pipes, stdin) are read by Binary_Stream_Reader instead
+    Binary_File_Reader(FILE *file, size_t triangle_count);
     ~Binary_File_Reader() override;
     bool read_next_triangle(Tiny_STL::Triangle *res) override;
+    size_t read_triangles(Tiny_STL::Triangle *out, size_t max_count) override;
+    size_t read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count) override;
+    size_t triangle_count() const override;
+    size_t read_range(size_t first, size_t count, Tiny_STL::Triangle *out) override;
 };
 
-Binary_File_Reader::Binary_File_Reader(FILE *file)
+Binary_File_Reader::Binary_File_Reader(FILE *file, size_t triangle_count)
 {
     m_file = file;
-    if (fseek(file, 84, SEEK_SET) != 0)
+    m_triangle_count = triangle_count;
+    m_triangles_left = triangle_count;
+    if (fseek(file, Tiny_STL::Binary_Record::TRIANGLES_OFFSET, SEEK_SET) != 0)
     {
         throw std::runtime_error("Failed to seek file");
     }
@@ -36,11 +53,124 @@ Binary_File_Reader::~Binary_File_Reader()
 
 bool Binary_File_Reader::read_next_triangle(Tiny_STL::Triangle *res)
 {
+    if (m_triangles_left == 0)
+    {
+        return false;
+    }
+
     bool success = (fread(res->normal, sizeof(float[3]), 1, m_file) == 1);
     success = success && (fread(res->vertices, sizeof(float[3][3]), 1, m_file) == 1);
 
     // Skip "attribute byte count", which is not stored in ASCII format,
     // and is rarely used by binary format
-    success = success && (fseek(m_file, sizeof(uint16_t), SEEK_CUR) == 0);
+    uint16_t attribute_byte_count;
+    success = success && (fread(&attribute_byte_count, sizeof(uint16_t), 1, m_file) == 1);
+    if (success)
+    {
+        m_triangles_left--;
+    }
     return success;
 }
+
+size_t Binary_File_Reader::read_triangles(Tiny_STL::Triangle *out, size_t max_count)
+{
+    return read_triangles_with_attributes(out, nullptr, max_count);
+}
+
+size_t Binary_File_Reader::read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count)
+{
+    if (max_count > m_triangles_left)
+    {
+        max_count = m_triangles_left;
+    }
+
+    // Read whole records in chunks, one fread per chunk instead of three stdio calls per triangle
+    constexpr size_t CHUNK_TRIANGLES = 256;
+    unsigned char chunk[CHUNK_TRIANGLES * Tiny_STL::Binary_Record::SIZE];
+
+    size_t count = 0;
+    while (count < max_count)
+    {
+        size_t wanted = max_count - count;
+        if (wanted > CHUNK_TRIANGLES)
+        {
+            wanted = CHUNK_TRIANGLES;
+        }
+
+        size_t num_read = fread(chunk, Tiny_STL::Binary_Record::SIZE, wanted, m_file);
+        Tiny_STL::Binary_Record::decode_records(chunk, num_read, out + count, attributes ? attributes + count : nullptr);
+        count += num_read;
+
+        if (num_read < wanted)
+        {
+            break;
+        }
+    }
+
+    m_triangles_left -= count;
+    return count;
+}
+
+size_t Binary_File_Reader::triangle_count() const
+{
+    return m_triangle_count;
+}
+
+size_t Binary_File_Reader::read_range(size_t first, size_t count, Tiny_STL::Triangle *out)
+{
+    if (first >= m_triangle_count)
+    {
+        return 0;
+    }
+    if (count > m_triangle_count - first)
+    {
+        count = m_triangle_count - first;
+    }
+
+    constexpr size_t CHUNK_TRIANGLES = 256;
+    unsigned char chunk[CHUNK_TRIANGLES * Tiny_STL::Binary_Record::SIZE];
+
+#if !TINY_STL_HAS_PREAD
+    long position = ftell(m_file);
+    if (position == -1L)
+    {
+        return 0;
+    }
+#endif
+
+    size_t num_done = 0;
+    while (num_done < count)
+    {
+        size_t wanted = count - num_done;
+        if (wanted > CHUNK_TRIANGLES)
+        {
+            wanted = CHUNK_TRIANGLES;
+        }
+
+        size_t offset = Tiny_STL::Binary_Record::TRIANGLES_OFFSET + (first + num_done) * Tiny_STL::Binary_Record::SIZE;
+#if TINY_STL_HAS_PREAD
+        // pread does not move the file offset, so sequential reading through stdio is not disturbed
+        ssize_t num_bytes = pread(fileno(m_file), chunk, wanted * Tiny_STL::Binary_Record::SIZE, (off_t)offset);
+        size_t num_read = (num_bytes > 0) ? (size_t)num_bytes / Tiny_STL::Binary_Record::SIZE : 0;
+#else
+        size_t num_read = 0;
+        if (fseek(m_file, (long)offset, SEEK_SET) == 0)
+        {
+            num_read = fread(chunk, Tiny_STL::Binary_Record::SIZE, wanted, m_file);
+        }
+#endif
+
+        Tiny_STL::Binary_Record::decode_records(chunk, num_read, out + num_done, nullptr);
+        num_done += num_read;
+
+        if (num_read < wanted)
+        {
+            break;
+        }
+    }
+
+#if !TINY_STL_HAS_PREAD
+    fseek(m_file, position, SEEK_SET);
+#endif
+    return num_done;
+}
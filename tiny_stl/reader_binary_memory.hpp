@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "mapped_file.hpp"
+#include "non_copyable.hpp"
+#include "parallel.hpp"
+#include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
+
+// Decodes triangles directly from binary STL data in memory,
+// does not own the data, which must outlive the reader
+class Binary_Memory_Reader : public Tiny_STL::Random_Access_Reader, public NonCopyable
+{
+private:
+    const unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+    const unsigned char *m_iter = nullptr;
+    const unsigned char *m_end = nullptr;
+    unsigned m_num_threads = 1;
+
+    void decode_in_parallel(const unsigned char *records, size_t count, Tiny_STL::Triangle *out, uint16_t *attributes) const;
+
+public:
+    Binary_Memory_Reader(const unsigned char *data, size_t size, unsigned num_threads = 1);
+    bool read_next_triangle(Tiny_STL::Triangle *res) override;
+    size_t read_triangles(Tiny_STL::Triangle *out, size_t max_count) override;
+    size_t read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count) override;
+    size_t read_views(Tiny_STL::Triangle_View *out, size_t max_count) override;
+    size_t triangle_count() const override;
+    size_t read_range(size_t first, size_t count, Tiny_STL::Triangle *out) override;
+};
+
+Binary_Memory_Reader::Binary_Memory_Reader(const unsigned char *data, size_t size, unsigned num_threads)
+    : m_data(data), m_size(size), m_num_threads(resolve_num_threads(num_threads))
+{
+    if (m_size < Tiny_STL::Binary_Record::TRIANGLES_OFFSET)
+    {
+        throw std::runtime_error("File too short");
+    }
+
+    m_iter = m_data + Tiny_STL::Binary_Record::TRIANGLES_OFFSET;
+    m_end = m_data + m_size;
+}
+
+bool Binary_Memory_Reader::read_next_triangle(Tiny_STL::Triangle *res)
+{
+    if ((size_t)(m_end - m_iter) < Tiny_STL::Binary_Record::SIZE)
+    {
+        return false;
+    }
+
+    Tiny_STL::Binary_Record::decode(m_iter, res);
+    m_iter += Tiny_STL::Binary_Record::SIZE;
+    return true;
+}
+
+void Binary_Memory_Reader::decode_in_parallel(const unsigned char *records, size_t count, Tiny_STL::Triangle *out, uint16_t *attributes) const
+{
+    // Records have a fixed size, so large requests are split into independent ranges,
+    // each decoded by its own thread straight into out,
+    // starting a thread costs about as much as decoding 2K triangles (~20us vs ~12ns per triangle),
+    // so only requests that give every thread at least 64K triangles are split, keeping that cost at a few percent
+    constexpr size_t MIN_TRIANGLES_PER_THREAD = 64 * 1024;
+    size_t num_ranges = count / MIN_TRIANGLES_PER_THREAD;
+    if (num_ranges > m_num_threads)
+    {
+        num_ranges = m_num_threads;
+    }
+    if (num_ranges < 1)
+    {
+        num_ranges = 1;
+    }
+
+    size_t range_size = (count + num_ranges - 1) / num_ranges;
+    parallel_for(num_ranges, m_num_threads, [&](size_t range)
+    {
+        size_t first = range * range_size;
+        size_t last = (first + range_size < count) ? (first + range_size) : count;
+        if (first < last)
+        {
+            Tiny_STL::Binary_Record::decode_records(records + first * Tiny_STL::Binary_Record::SIZE, last - first, out + first,
+                                                    attributes ? attributes + first : nullptr);
+        }
+    });
+}
+
+size_t Binary_Memory_Reader::read_triangles(Tiny_STL::Triangle *out, size_t max_count)
+{
+    return read_triangles_with_attributes(out, nullptr, max_count);
+}
+
+size_t Binary_Memory_Reader::read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count)
+{
+    size_t available = (size_t)(m_end - m_iter) / Tiny_STL::Binary_Record::SIZE;
+    size_t count = (max_count < available) ? max_count : available;
+    decode_in_parallel(m_iter, count, out, attributes);
+    m_iter += count * Tiny_STL::Binary_Record::SIZE;
+    return count;
+}
+
+size_t Binary_Memory_Reader::read_views(Tiny_STL::Triangle_View *out, size_t max_count)
+{
+    // Records start with the 12 floats of the triangle, so views point straight at them
+    size_t available = (size_t)(m_end - m_iter) / Tiny_STL::Binary_Record::SIZE;
+    size_t count = (max_count < available) ? max_count : available;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = Tiny_STL::Triangle_View(m_iter + i * Tiny_STL::Binary_Record::SIZE);
+    }
+    m_iter += count * Tiny_STL::Binary_Record::SIZE;
+    return count;
+}
+
+size_t Binary_Memory_Reader::triangle_count() const
+{
+    return (m_size - Tiny_STL::Binary_Record::TRIANGLES_OFFSET) / Tiny_STL::Binary_Record::SIZE;
+}
+
+size_t Binary_Memory_Reader::read_range(size_t first, size_t count, Tiny_STL::Triangle *out)
+{
+    size_t num_triangles = triangle_count();
+    if (first >= num_triangles)
+    {
+        return 0;
+    }
+    if (count > num_triangles - first)
+    {
+        count = num_triangles - first;
+    }
+
+    decode_in_parallel(m_data + Tiny_STL::Binary_Record::TRIANGLES_OFFSET + first * Tiny_STL::Binary_Record::SIZE, count, out, nullptr);
+    return count;
+}
+
+#if TINY_STL_HAS_MMAP
+
+// Decodes triangles directly from a memory mapping of the file,
+// avoids the per-facet stdio calls of Binary_File_Reader
+class Binary_Mmap_File_Reader final : public Binary_Memory_Reader
+{
+private:
+    std::unique_ptr<Mapped_File> m_mapping;
+
+    Binary_Mmap_File_Reader(std::unique_ptr<Mapped_File> mapping, size_t num_triangles, unsigned num_threads);
+    static std::unique_ptr<Mapped_File> map_and_close(FILE *file, size_t file_size, Map_Access access);
+
+public:
+    // Only the first num_triangles records are read, anything after them is ignored,
+    // access should be RANDOM when ranges are read with read_range rather than front to back
+    Binary_Mmap_File_Reader(FILE *file, size_t file_size, size_t num_triangles, unsigned num_threads = 1,
+                            Map_Access access = Map_Access::SEQUENTIAL);
+};
+
+std::unique_ptr<Mapped_File> Binary_Mmap_File_Reader::map_and_close(FILE *file, size_t file_size, Map_Access access)
+{
+    std::unique_ptr<Mapped_File> mapping;
+    try
+    {
+        mapping.reset(new Mapped_File(file, file_size, access));
+    }
+    catch (...)
+    {
+        fclose(file);
+        throw;
+    }
+    fclose(file);
+    return mapping;
+}
+
+Binary_Mmap_File_Reader::Binary_Mmap_File_Reader(FILE *file, size_t file_size, size_t num_triangles, unsigned num_threads, Map_Access access)
+    : Binary_Mmap_File_Reader(map_and_close(file, file_size, access), num_triangles, num_threads)
+{
+}
+
+Binary_Mmap_File_Reader::Binary_Mmap_File_Reader(std::unique_ptr<Mapped_File> mapping, size_t num_triangles, unsigned num_threads)
+    : Binary_Memory_Reader(mapping->data(), Tiny_STL::Binary_Record::TRIANGLES_OFFSET + num_triangles * Tiny_STL::Binary_Record::SIZE, num_threads),
+      m_mapping(std::move(mapping))
+{
+}
+
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+
+#include "input_stream.hpp"
+#include "non_copyable.hpp"
+#include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
+
+// Reads binary files sequentially from an input stream,
+// for pipes, stdin and compressed files, which cannot be seeked or mapped
+class Binary_Stream_Reader final : public Tiny_STL::File_Reader, public NonCopyable
+{
+private:
+    std::unique_ptr<Input_Stream> m_input;
+
+    // Records are read in large blocks, a partial record at the end of a block is carried over
+    static constexpr size_t BUFFER_TRIANGLES = 4096;
+    std::unique_ptr<unsigned char[]> m_buffer;
+    size_t m_pos = 0;
+    size_t m_filled = 0;
+    bool m_eof = false;
+    size_t m_triangles_left = 0;
+
+    // Returns number of whole records available in the buffer
+    size_t available_records();
+
+public:
+    // input is positioned right after the header,
+    // prefix holds bytes following the header that were already consumed from it
+    Binary_Stream_Reader(std::unique_ptr<Input_Stream> input, size_t triangle_count,
+                         const unsigned char *prefix = nullptr, size_t prefix_size = 0);
+    bool read_next_triangle(Tiny_STL::Triangle *res) override;
+    size_t read_triangles(Tiny_STL::Triangle *out, size_t max_count) override;
+    size_t read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count) override;
+};
+
+Binary_Stream_Reader::Binary_Stream_Reader(std::unique_ptr<Input_Stream> input, size_t triangle_count,
+                                           const unsigned char *prefix, size_t prefix_size)
+    : m_input(std::move(input)), m_triangles_left(triangle_count)
+{
+    size_t buffer_size = BUFFER_TRIANGLES * Tiny_STL::Binary_Record::SIZE;
+    if (buffer_size < prefix_size)
+    {
+        buffer_size = prefix_size;
+    }
+    m_buffer.reset(new unsigned char[buffer_size]);
+    if (prefix_size > 0)
+    {
+        memcpy(m_buffer.get(), prefix, prefix_size);
+    }
+    m_filled = prefix_size;
+}
+
+size_t Binary_Stream_Reader::available_records()
+{
+    size_t available = (m_filled - m_pos) / Tiny_STL::Binary_Record::SIZE;
+    if (available > 0 || m_eof)
+    {
+        return available;
+    }
+
+    size_t remaining = m_filled - m_pos;
+    memmove(m_buffer.get(), m_buffer.get() + m_pos, remaining);
+    m_pos = 0;
+    m_filled = remaining;
+
+    size_t wanted = BUFFER_TRIANGLES * Tiny_STL::Binary_Record::SIZE - remaining;
+    size_t num_read = m_input->read(m_buffer.get() + remaining, wanted);
+    m_filled += num_read;
+    m_eof = (num_read < wanted);
+    return m_filled / Tiny_STL::Binary_Record::SIZE;
+}
+
+bool Binary_Stream_Reader::read_next_triangle(Tiny_STL::Triangle *res)
+{
+    return read_triangles(res, 1) == 1;
+}
+
+size_t Binary_Stream_Reader::read_triangles(Tiny_STL::Triangle *out, size_t max_count)
+{
+    return read_triangles_with_attributes(out, nullptr, max_count);
+}
+
+size_t Binary_Stream_Reader::read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count)
+{
+    if (max_count > m_triangles_left)
+    {
+        max_count = m_triangles_left;
+    }
+
+    size_t count = 0;
+    while (count < max_count)
+    {
+        size_t available = available_records();
+        if (available == 0)
+        {
+            break;
+        }
+
+        size_t n = (max_count - count < available) ? (max_count - count) : available;
+        Tiny_STL::Binary_Record::decode_records(m_buffer.get() + m_pos, n, out + count, attributes ? attributes + count : nullptr);
+        m_pos += n * Tiny_STL::Binary_Record::SIZE;
+        count += n;
+    }
+
+    m_triangles_left -= count;
+    return count;
+}
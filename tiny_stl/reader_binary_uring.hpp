@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+#include "non_copyable.hpp"
+#include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
+
+#if TINY_STL_HAS_IO_URING
+
+#include <liburing.h>
+
+// Reads binary files through io_uring, keeping several large block reads in flight
+// so that decoding the current block overlaps reading the following ones,
+// without blocking a thread per outstanding read
+class Binary_Uring_File_Reader final : public Tiny_STL::File_Reader, public NonCopyable
+{
+private:
+    static constexpr unsigned QUEUE_DEPTH = 4;
+    // Blocks hold whole records, so a record never spans two blocks
+    static constexpr size_t READ_BLOCK_SIZE = 16 * 1024 * Tiny_STL::Binary_Record::SIZE;
+
+    struct Block
+    {
+        std::unique_ptr<unsigned char[]> data;
+        uint64_t offset = 0;
+        size_t size = 0; // 0 when there is nothing left to read into this block
+        size_t filled = 0;
+    };
+
+    FILE *m_file = nullptr;
+    io_uring m_ring;
+    Block m_blocks[QUEUE_DEPTH];
+    unsigned m_in_flight = 0;
+
+    uint64_t m_next_offset = 0;
+    uint64_t m_end_offset = 0;
+
+    // Blocks are consumed in file order, round robin over m_blocks
+    unsigned m_current = 0;
+    size_t m_consumed = 0;
+    bool m_current_ready = false;
+    // Set once a read failed, no triangles are returned afterwards
+    bool m_failed = false;
+
+    void close();
+    void submit(unsigned index);
+    void start_block(unsigned index);
+    void complete_one();
+    bool wait_current();
+
+public:
+    Binary_Uring_File_Reader(FILE *file, size_t num_triangles);
+    ~Binary_Uring_File_Reader() override;
+    // Throws when a read fails, the reader then returns no more triangles
+    bool read_next_triangle(Tiny_STL::Triangle *res) override;
+    size_t read_triangles(Tiny_STL::Triangle *out, size_t max_count) override;
+    size_t read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count) override;
+};
+
+Binary_Uring_File_Reader::Binary_Uring_File_Reader(FILE *file, size_t num_triangles)
+{
+    m_file = file;
+
+    int error = io_uring_queue_init(QUEUE_DEPTH, &m_ring, 0);
+    if (error < 0)
+    {
+        fclose(file);
+        throw std::runtime_error("Failed to initialize io_uring");
+    }
+
+    m_next_offset = Tiny_STL::Binary_Record::TRIANGLES_OFFSET;
+    m_end_offset = Tiny_STL::Binary_Record::TRIANGLES_OFFSET + (uint64_t)num_triangles * Tiny_STL::Binary_Record::SIZE;
+
+    try
+    {
+        for (unsigned i = 0; i < QUEUE_DEPTH; i++)
+        {
+            m_blocks[i].data.reset(new unsigned char[READ_BLOCK_SIZE]);
+            start_block(i);
+        }
+    }
+    catch (...)
+    {
+        // Blocks are only freed after the reads already started on them are done
+        close();
+        throw;
+    }
+}
+
+Binary_Uring_File_Reader::~Binary_Uring_File_Reader()
+{
+    close();
+}
+
+void Binary_Uring_File_Reader::close()
+{
+    // Kernel may still be writing into blocks, wait for outstanding reads before freeing them
+    while (m_in_flight > 0)
+    {
+        io_uring_cqe *cqe = nullptr;
+        if (io_uring_wait_cqe(&m_ring, &cqe) < 0)
+        {
+            break;
+        }
+        io_uring_cqe_seen(&m_ring, cqe);
+        m_in_flight--;
+    }
+    io_uring_queue_exit(&m_ring);
+    fclose(m_file);
+}
+
+void Binary_Uring_File_Reader::submit(unsigned index)
+{
+    Block &block = m_blocks[index];
+    io_uring_sqe *sqe = io_uring_get_sqe(&m_ring);
+    if (sqe == nullptr)
+    {
+        m_failed = true;
+        throw std::runtime_error("io_uring submission queue is full");
+    }
+
+    io_uring_prep_read(sqe, fileno(m_file), block.data.get() + block.filled,
+                       (unsigned)(block.size - block.filled), block.offset + block.filled);
+    io_uring_sqe_set_data(sqe, &block);
+    if (io_uring_submit(&m_ring) < 0)
+    {
+        m_failed = true;
+        throw std::runtime_error("Failed to submit io_uring read");
+    }
+    m_in_flight++;
+}
+
+void Binary_Uring_File_Reader::start_block(unsigned index)
+{
+    Block &block = m_blocks[index];
+    block.filled = 0;
+    block.offset = m_next_offset;
+    block.size = 0;
+    if (m_next_offset >= m_end_offset)
+    {
+        return;
+    }
+
+    uint64_t remaining = m_end_offset - m_next_offset;
+    block.size = (remaining < READ_BLOCK_SIZE) ? (size_t)remaining : READ_BLOCK_SIZE;
+    m_next_offset += block.size;
+    submit(index);
+}
+
+void Binary_Uring_File_Reader::complete_one()
+{
+    io_uring_cqe *cqe = nullptr;
+    if (io_uring_wait_cqe(&m_ring, &cqe) < 0)
+    {
+        m_failed = true;
+        throw std::runtime_error("Failed to wait for io_uring completion");
+    }
+
+    Block *block = static_cast<Block *>(io_uring_cqe_get_data(cqe));
+    int res = cqe->res;
+    io_uring_cqe_seen(&m_ring, cqe);
+    m_in_flight--;
+
+    if (res < 0)
+    {
+        // The block will never be filled, waiting for it again would block forever
+        m_failed = true;
+        throw std::runtime_error("Failed to read from file");
+    }
+    if (res == 0)
+    {
+        // File was truncated after it was opened, keep what was read
+        block->size = block->filled;
+        return;
+    }
+
+    block->filled += (size_t)res;
+    if (block->filled < block->size)
+    {
+        // Short read, ask for the rest of the block
+        submit((unsigned)(block - m_blocks));
+    }
+}
+
+bool Binary_Uring_File_Reader::wait_current()
+{
+    Block &block = m_blocks[m_current];
+    while (block.filled < block.size)
+    {
+        complete_one();
+    }
+    return block.size >= Tiny_STL::Binary_Record::SIZE;
+}
+
+bool Binary_Uring_File_Reader::read_next_triangle(Tiny_STL::Triangle *res)
+{
+    return read_triangles(res, 1) == 1;
+}
+
+size_t Binary_Uring_File_Reader::read_triangles(Tiny_STL::Triangle *out, size_t max_count)
+{
+    return read_triangles_with_attributes(out, nullptr, max_count);
+}
+
+size_t Binary_Uring_File_Reader::read_triangles_with_attributes(Tiny_STL::Triangle *out, uint16_t *attributes, size_t max_count)
+{
+    size_t count = 0;
+    while (count < max_count && !m_failed)
+    {
+        if (!m_current_ready)
+        {
+            if (!wait_current())
+            {
+                break;
+            }
+            m_consumed = 0;
+            m_current_ready = true;
+        }
+
+        Block &block = m_blocks[m_current];
+        size_t available = (block.size - m_consumed) / Tiny_STL::Binary_Record::SIZE;
+        size_t n = (max_count - count < available) ? (max_count - count) : available;
+        Tiny_STL::Binary_Record::decode_records(block.data.get() + m_consumed, n, out + count, attributes ? attributes + count : nullptr);
+        m_consumed += n * Tiny_STL::Binary_Record::SIZE;
+        count += n;
+
+        if (block.size - m_consumed < Tiny_STL::Binary_Record::SIZE)
+        {
+            // Block is used up, reuse it for the next block past the ones already in flight
+            start_block(m_current);
+            m_current = (m_current + 1) % QUEUE_DEPTH;
+            m_current_ready = false;
+        }
+    }
+    return count;
+}
+
+#endif
@@ -1,25 +1,68 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 
+#include "output.hpp"
 #include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
 #include "writer_ascii.hpp"
 #include "writer_binary.hpp"
 
 namespace Tiny_STL
 {
-    std::unique_ptr<File_Writer> create_writer(const char *filepath, File_Writer::Type type)
+    // Checked before the output is opened, so an existing file is left untouched
+    static void check_options(const Writer_Options &options)
+    {
+        // Binary headers store the count in 32 bits
+        if ((uint64_t)options.triangle_count > UINT32_MAX)
+        {
+            throw std::runtime_error("Triangle count does not fit in a binary STL header");
+        }
+    }
+
+    static std::unique_ptr<File_Writer> create_writer(std::unique_ptr<Output> output, File_Writer::Type type, const Writer_Options &options)
     {
         if (type == File_Writer::Type::ASCII)
         {
-            return std::make_unique<ASCII_File_Writer>(filepath);
+            return std::make_unique<ASCII_File_Writer>(std::move(output), options.num_threads, options.solid_name);
         }
         else if (type == File_Writer::Type::BINARY)
         {
-            return std::make_unique<Binary_File_Writer>(filepath);
+            // Without an explicit header the solid name is stored, truncated to the header size
+            unsigned char header[Binary_Record::HEADER_SIZE] = {};
+            if (options.binary_header != nullptr)
+            {
+                memcpy(header, options.binary_header, Binary_Record::HEADER_SIZE);
+            }
+            else
+            {
+                size_t name_size = std::min(options.solid_name.size(), Binary_Record::HEADER_SIZE);
+                memcpy(header, options.solid_name.data(), name_size);
+            }
+            return std::make_unique<Binary_File_Writer>(std::move(output), (uint32_t)options.triangle_count, header);
         }
         else
         {
             throw std::runtime_error("Not implemented");
         }
     }
+
+    std::unique_ptr<File_Writer> create_writer(const char *filepath, File_Writer::Type type, const Writer_Options &options)
+    {
+        check_options(options);
+        if (type == File_Writer::Type::BINARY && options.triangle_count != 0)
+        {
+            uint64_t expected_size = Binary_Record::TRIANGLES_OFFSET + (uint64_t)options.triangle_count * Binary_Record::SIZE;
+            return create_writer(std::make_unique<Output>(filepath, expected_size), type, options);
+        }
+        return create_writer(std::make_unique<Output>(filepath), type, options);
+    }
+
+    std::unique_ptr<File_Writer> create_writer(std::vector<char> *buffer, File_Writer::Type type, const Writer_Options &options)
+    {
+        check_options(options);
+        return create_writer(std::make_unique<Output>(buffer), type, options);
+    }
 }
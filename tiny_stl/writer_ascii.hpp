@@ -1,43 +1,178 @@
 #pragma once
 
-#include <fmt/os.h>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
 
 #include "non_copyable.hpp"
+#include "output.hpp"
+#include "parallel.hpp"
 #include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
 
-class ASCII_File_Writer : public Tiny_STL::File_Writer, public NonCopyable
+class ASCII_File_Writer final : public Tiny_STL::File_Writer, public NonCopyable
 {
 private:
-    fmt::ostream m_file;
+    std::unique_ptr<Output> m_output;
+    fmt::memory_buffer m_buffer;
+    unsigned m_num_threads = 1;
+    std::string m_solid_name;
+
+    // Formatted text is accumulated and handed to the file in large writes
+    static constexpr size_t FLUSH_THRESHOLD = 1024 * 1024;
+
+    void flush();
+    void write_triangles_in_parallel(const Tiny_STL::Triangle *t, size_t count);
 
 public:
-    explicit ASCII_File_Writer(const char *filepath);
+    explicit ASCII_File_Writer(std::unique_ptr<Output> output, unsigned num_threads = 1, const std::string &solid_name = std::string());
     ~ASCII_File_Writer() override;
     void write_triangle(const Tiny_STL::Triangle *t) override;
+    void write_triangles(const Tiny_STL::Triangle *t, size_t count) override;
 };
 
-ASCII_File_Writer::ASCII_File_Writer(const char *filepath) : m_file(fmt::output_file(filepath))
+ASCII_File_Writer::ASCII_File_Writer(std::unique_ptr<Output> output, unsigned num_threads, const std::string &solid_name)
+    : m_output(std::move(output)), m_solid_name(solid_name)
+{
+    m_num_threads = resolve_num_threads(num_threads);
+    fmt::format_to(std::back_inserter(m_buffer), "solid {}\n", m_solid_name);
+}
+
+// Longest output of shortest round trip formatting of a float is 14 characters ("-1.1754944e-38"),
+// with margin for fixed notation of large values
+static constexpr size_t MAX_FLOAT_CHARS = 24;
+static constexpr size_t MAX_FACET_CHARS = 12 * MAX_FLOAT_CHARS + 128;
+
+template <size_t N>
+static inline char *append_literal(char *out, const char (&literal)[N])
 {
-    m_file.print("solid \n");
+    memcpy(out, literal, N - 1);
+    return out + N - 1;
+}
+
+// Plain "{}" takes fmt's fast path that skips format string parsing,
+// and formats the shortest representation that round trips (Dragonbox)
+static inline char *append_float3(char *out, const float values[3])
+{
+    out = fmt::format_to(out, "{}", values[0]);
+    *out++ = ' ';
+    out = fmt::format_to(out, "{}", values[1]);
+    *out++ = ' ';
+    out = fmt::format_to(out, "{}", values[2]);
+    *out++ = '\n';
+    return out;
+}
+
+static char *format_facet(const Tiny_STL::Triangle *t, char *out)
+{
+    out = append_literal(out, "facet normal ");
+    out = append_float3(out, t->normal);
+    out = append_literal(out, "\touter loop\n");
+    for (int i = 0; i < 3; i++)
+    {
+        out = append_literal(out, "\t\tvertex ");
+        out = append_float3(out, t->vertices[i]);
+    }
+    out = append_literal(out, "\tendloop\n"
+                              "endfacet\n");
+    return out;
+}
+
+static void format_triangle(fmt::memory_buffer &buffer, const Tiny_STL::Triangle *t)
+{
+    // Facet is written straight into space reserved at the end of the buffer
+    size_t offset = buffer.size();
+    buffer.resize(offset + MAX_FACET_CHARS);
+    char *out = format_facet(t, buffer.data() + offset);
+    buffer.resize(out - buffer.data());
+}
+
+void ASCII_File_Writer::flush()
+{
+    if (m_buffer.size() == 0)
+    {
+        return;
+    }
+
+    m_output->write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
 }
 
 void ASCII_File_Writer::write_triangle(const Tiny_STL::Triangle *t)
 {
-    m_file.print("facet normal {} {} {}\n"
-                 "\touter loop\n"
-                 "\t\tvertex {} {} {}\n"
-                 "\t\tvertex {} {} {}\n"
-                 "\t\tvertex {} {} {}\n"
-                 "\tendloop\n"
-                 "endfacet\n",
+    format_triangle(m_buffer, t);
+    if (m_buffer.size() >= FLUSH_THRESHOLD)
+    {
+        flush();
+    }
+}
+
+void ASCII_File_Writer::write_triangles_in_parallel(const Tiny_STL::Triangle *t, size_t count)
+{
+    // Blocks are formatted concurrently into their own buffers, then written in order,
+    // one round of blocks at a time so memory use does not grow with count
+    constexpr size_t BLOCK_TRIANGLES = 16 * 1024;
+    std::vector<fmt::memory_buffer> blocks(m_num_threads);
+
+    flush();
+    size_t done = 0;
+    while (done < count)
+    {
+        size_t round_size = count - done;
+        if (round_size > BLOCK_TRIANGLES * m_num_threads)
+        {
+            round_size = BLOCK_TRIANGLES * m_num_threads;
+        }
+        size_t num_blocks = (round_size + BLOCK_TRIANGLES - 1) / BLOCK_TRIANGLES;
+
+        parallel_for(num_blocks, m_num_threads, [&](size_t block)
+        {
+            size_t first = done + block * BLOCK_TRIANGLES;
+            size_t last = (first + BLOCK_TRIANGLES < done + round_size) ? (first + BLOCK_TRIANGLES) : (done + round_size);
+            fmt::memory_buffer &buffer = blocks[block];
+            buffer.clear();
+            for (size_t i = first; i < last; i++)
+            {
+                format_triangle(buffer, t + i);
+            }
+        });
+
+        for (size_t block = 0; block < num_blocks; block++)
+        {
+            m_output->write(blocks[block].data(), blocks[block].size());
+        }
+        done += round_size;
+    }
+}
+
+void ASCII_File_Writer::write_triangles(const Tiny_STL::Triangle *t, size_t count)
+{
+    constexpr size_t MIN_PARALLEL_TRIANGLES = 32 * 1024;
+    if (m_num_threads > 1 && count >= MIN_PARALLEL_TRIANGLES)
+    {
+        write_triangles_in_parallel(t, count);
+        return;
+    }
 
-                 t->normal[0], t->normal[1], t->normal[2],
-                 t->vertices[0][0], t->vertices[0][1], t->vertices[0][2],
-                 t->vertices[1][0], t->vertices[1][1], t->vertices[1][2],
-                 t->vertices[2][0], t->vertices[2][1], t->vertices[2][2]);
+    for (size_t i = 0; i < count; i++)
+    {
+        format_triangle(m_buffer, t + i);
+        if (m_buffer.size() >= FLUSH_THRESHOLD)
+        {
+            flush();
+        }
+    }
+    flush();
 }
 
 ASCII_File_Writer::~ASCII_File_Writer()
 {
-    m_file.print("endsolid \n");
+    fmt::format_to(std::back_inserter(m_buffer), "endsolid {}\n", m_solid_name);
+    flush();
 }
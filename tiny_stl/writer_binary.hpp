@@ -3,56 +3,104 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include <stdexcept>
 
 #include "non_copyable.hpp"
+#include "output.hpp"
 #include "tiny_stl.hpp"
+#include "tiny_stl_static.hpp"
 
-class Binary_File_Writer : public Tiny_STL::File_Writer, public NonCopyable
+class Binary_File_Writer final : public Tiny_STL::File_Writer, public NonCopyable
 {
 private:
-    FILE *m_file = nullptr;
+    std::unique_ptr<Output> m_output;
     uint32_t num_tris = 0;
-    static constexpr size_t BINARY_HEADER_SIZE = 80;
+    uint32_t m_expected_count = 0;
+    static constexpr size_t BINARY_HEADER_SIZE = Tiny_STL::Binary_Record::HEADER_SIZE;
 
 public:
-    explicit Binary_File_Writer(const char *filepath);
+    // expected_count is written in the header right away,
+    // it is only patched at the end if a different number of triangles was written,
+    // header holds the 80 header bytes, zero filled when nullptr
+    explicit Binary_File_Writer(std::unique_ptr<Output> output, uint32_t expected_count = 0, const unsigned char *header = nullptr);
     ~Binary_File_Writer() override;
     void write_triangle(const Tiny_STL::Triangle *t) override;
+    void write_triangles(const Tiny_STL::Triangle *t, size_t count) override;
+    void write_triangles_with_attributes(const Tiny_STL::Triangle *t, const uint16_t *attributes, size_t count) override;
 };
 
-Binary_File_Writer::Binary_File_Writer(const char *filepath)
+Binary_File_Writer::Binary_File_Writer(std::unique_ptr<Output> output, uint32_t expected_count, const unsigned char *header)
+    : m_output(std::move(output)), m_expected_count(expected_count)
 {
-    m_file = fopen(filepath, "wb");
-    if (m_file == nullptr)
+    unsigned char empty_header[BINARY_HEADER_SIZE] = {};
+    m_output->write(header ? header : empty_header, BINARY_HEADER_SIZE);
+    // Write expected number of triangles (placeholder when unknown),
+    // so that it can be updated later (after all triangles have been written)
+    m_output->write(&m_expected_count, sizeof(uint32_t));
+}
+
+void Binary_File_Writer::write_triangle(const Tiny_STL::Triangle *t)
+{
+    unsigned char record[Tiny_STL::Binary_Record::SIZE];
+    Tiny_STL::Binary_Record::encode(t, 0, record);
+    if (m_output->write(record, sizeof(record)) == sizeof(record))
     {
-        throw std::runtime_error("Failed to open file");
+        num_tris++;
     }
+}
 
-    char header[BINARY_HEADER_SIZE] = {};
-    fwrite(header, 1, BINARY_HEADER_SIZE, m_file);
-    // Write placeholder for number of triangles,
-    // so that it can be updated later (after all triangles have been written)
-    fwrite(&num_tris, sizeof(uint32_t), 1, m_file);
+void Binary_File_Writer::write_triangles(const Tiny_STL::Triangle *t, size_t count)
+{
+    write_triangles_with_attributes(t, nullptr, count);
 }
 
-void Binary_File_Writer::write_triangle(const Tiny_STL::Triangle *t)
+void Binary_File_Writer::write_triangles_with_attributes(const Tiny_STL::Triangle *t, const uint16_t *attributes, size_t count)
 {
-    bool success = (fwrite(t->normal, sizeof(float[3]), 1, m_file) == 1);
-    success = success && (fwrite(t->vertices, sizeof(float[3][3]), 1, m_file) == 1);
+    // Encode records into a large buffer and hand each chunk to the output in a single write
+    constexpr size_t CHUNK_TRIANGLES = 64 * 1024;
+    size_t chunk_triangles = (count < CHUNK_TRIANGLES) ? count : CHUNK_TRIANGLES;
+    std::unique_ptr<unsigned char[]> chunk(new unsigned char[chunk_triangles * Tiny_STL::Binary_Record::SIZE]);
 
-    uint16_t attribute_byte_count = 0;
-    success = success && (fwrite(&attribute_byte_count, sizeof(uint16_t), 1, m_file) == 1);
-    if (success)
+    size_t written = 0;
+    while (written < count)
     {
-        num_tris++;
+        size_t n = count - written;
+        if (n > chunk_triangles)
+        {
+            n = chunk_triangles;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            uint16_t attribute_byte_count = (attributes != nullptr) ? attributes[written + i] : 0;
+            Tiny_STL::Binary_Record::encode(t + written + i, attribute_byte_count, chunk.get() + i * Tiny_STL::Binary_Record::SIZE);
+        }
+
+        size_t num_written = m_output->write(chunk.get(), n * Tiny_STL::Binary_Record::SIZE) / Tiny_STL::Binary_Record::SIZE;
+        num_tris += (uint32_t)num_written;
+        if (num_written < n)
+        {
+            return;
+        }
+        written += n;
     }
 }
 
 Binary_File_Writer::~Binary_File_Writer()
 {
-    assert(m_file != nullptr);
-    fseek(m_file, BINARY_HEADER_SIZE, SEEK_SET);
-    fwrite(&num_tris, sizeof(uint32_t), 1, m_file);
-    fclose(m_file);
+    assert(m_output != nullptr);
+    // Records accepted by the output but lost when flushing are not counted
+    uint64_t stored = m_output->flush();
+    uint64_t stored_tris = (stored > Tiny_STL::Binary_Record::TRIANGLES_OFFSET)
+                               ? (stored - Tiny_STL::Binary_Record::TRIANGLES_OFFSET) / Tiny_STL::Binary_Record::SIZE
+                               : 0;
+    if (stored_tris < num_tris)
+    {
+        num_tris = (uint32_t)stored_tris;
+    }
+    if (num_tris != m_expected_count)
+    {
+        m_output->overwrite(BINARY_HEADER_SIZE, &num_tris, sizeof(uint32_t));
+    }
 }